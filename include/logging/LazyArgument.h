@@ -0,0 +1,76 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/** 
+ * @file
+ * \addtogroup Logging
+ * @{
+ */
+
+#ifndef LOGGING_LAZYARGUMENT_H_
+#define LOGGING_LAZYARGUMENT_H_
+
+#include <ostream>
+
+namespace logging {
+
+/**
+ * Wraps an expensive log argument.
+ *
+ * The wrapped callable is only invoked when the LazyArgument is actually
+ * written to a stream that is able to take it, i.e. when the LogRecord it is
+ * streamed into belongs to a message that will be printed. Use LOG_LAZY()
+ * to create one.
+ *
+ * @author  Moritz Höwer (Moritz.Hoewer@haw-hamburg.de)
+ * @version 1.0
+ */
+template<typename F>
+class LazyArgument {
+private:
+    F function; ///< the callable producing the value to print
+public:
+    /**
+     * Constructs a LazyArgument.
+     *
+     * @param function the callable producing the value to print
+     */
+    explicit LazyArgument(F function) :
+            function(function) {
+    }
+
+    /**
+     * Invokes the callable and prints its result, if the stream is good.
+     *
+     * @param os the std::ostream to print to
+     * @param arg the LazyArgument to print
+     *
+     * @return os
+     */
+    friend std::ostream& operator<<(std::ostream& os, const LazyArgument& arg) {
+        if (os) {
+            os << arg.function();
+        }
+        return os;
+    }
+};
+
+/**
+ * Creates a LazyArgument (deduces the type of the callable).
+ *
+ * @param function the callable producing the value to print
+ * @return a LazyArgument wrapping function
+ */
+template<typename F>
+inline LazyArgument<F> makeLazyArgument(F function) {
+    return LazyArgument<F>(function);
+}
+
+} /* namespace logging */
+
+#endif /* LOGGING_LAZYARGUMENT_H_ */
+/** @} */
@@ -0,0 +1,108 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/** 
+ * @file
+ * \addtogroup Logging
+ * @{
+ */
+
+#ifndef LOGGING_LOGINDEX_H_
+#define LOGGING_LOGINDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace logging {
+
+// forward declarations
+enum class LogLevel;
+
+/**
+ * Default size of the blocks of a logfile that are described by one entry of
+ * the index.
+ */
+constexpr std::uint64_t LOGINDEX_BLOCK_SIZE = 64 * 1024;
+
+/**
+ * Extension of the index file (appended to the name of the logfile)
+ */
+#define LOGINDEX_EXTENSION ".idx"
+
+/**
+ * The fields of a log line the index is interested in.
+ */
+struct LogLine {
+    std::uint32_t time; ///< time since start in ms
+    LogLevel logLevel; ///< the LogLevel
+    const char* module; ///< the module (not terminated)
+    std::size_t moduleLength; ///< length of the module
+};
+
+/**
+ * Describes a block of a logfile: where it is and which messages it contains.
+ */
+struct LogIndexBlock {
+    std::uint64_t offset; ///< offset of the block in the logfile
+    std::uint64_t length; ///< length of the block in bytes
+    std::uint32_t minTime; ///< earliest time of a message in the block (ms)
+    std::uint32_t maxTime; ///< latest time of a message in the block (ms)
+    std::uint32_t logLevels; ///< bitmap of the LogLevels in the block
+    std::uint64_t modules; ///< bitmap of the hashed modules in the block
+    std::uint64_t checksum; ///< FNV-1a hash of the bytes of the block
+
+    LogIndexBlock(std::uint64_t offset = 0);
+
+    bool isEmpty() const;
+    bool mayContain(std::uint32_t logLevels, std::uint64_t modules,
+            std::uint32_t from, std::uint32_t to) const;
+};
+
+/**
+ * Builds the index of a logfile while (or after) it is written.
+ *
+ * Messages are added in the order they appear in the logfile. A block is
+ * completed as soon as it is at least blockSize bytes long, so blocks always
+ * end at the end of a message.
+ *
+ * @author  Moritz Höwer (Moritz.Hoewer@haw-hamburg.de)
+ * @version 1.0
+ */
+class LogIndexBuilder {
+private:
+    std::uint64_t blockSize; ///< minimum size of a block
+    LogIndexBlock current; ///< the block being built
+    std::vector<LogIndexBlock> blocks; ///< completed blocks
+public:
+    explicit LogIndexBuilder(std::uint64_t offset = 0,
+            std::uint64_t blockSize = LOGINDEX_BLOCK_SIZE);
+
+    void add(const char* message, std::size_t length);
+    void finish();
+    std::vector<LogIndexBlock> takeBlocks();
+};
+
+bool parseLogLine(const char* begin, const char* end, LogLine& line);
+bool parseTime(const std::string& time, std::uint32_t& ms);
+std::uint64_t getModuleBit(const char* module, std::size_t length);
+std::uint64_t updateChecksum(std::uint64_t checksum, const char* data,
+        std::size_t length);
+
+void writeLogIndexHeader(std::ostream& os, std::uint64_t blockSize);
+void writeLogIndexBlock(std::ostream& os, const LogIndexBlock& block);
+bool readLogIndex(const std::string& filename, const char* data,
+        std::size_t length, std::vector<LogIndexBlock>& blocks);
+std::vector<LogIndexBlock> buildLogIndex(const char* data, std::size_t length,
+        std::uint64_t blockSize = LOGINDEX_BLOCK_SIZE);
+
+} /* namespace logging */
+
+#endif /* LOGGING_LOGINDEX_H_ */
+/** @} */
@@ -0,0 +1,50 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * \addtogroup Logging
+ * @{
+ */
+
+#ifndef LOGGING_LOGQUERY_H_
+#define LOGGING_LOGQUERY_H_
+
+#include "logging/LogIndex.h"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace logging {
+
+/**
+ * A query for log messages
+ */
+struct LogQuery {
+    std::uint32_t logLevels = 0; ///< bitmap of the LogLevels to look for
+    std::string module; ///< the module to look for, empty = all
+    std::uint32_t from = 0; ///< earliest time (ms)
+    std::uint32_t to = std::numeric_limits<std::uint32_t>::max(); ///< latest time (ms)
+
+    bool matches(const LogLine& line) const;
+};
+
+std::vector<LogIndexBlock> selectLogBlocks(const char* data,
+        std::size_t length, const std::vector<LogIndexBlock>& blocks,
+        const LogQuery& query, std::uint64_t blockSize = LOGINDEX_BLOCK_SIZE);
+std::string scanLogBlock(const char* begin, const char* end,
+        const LogQuery& query);
+std::string queryLog(const char* data, std::size_t length,
+        const std::vector<LogIndexBlock>& blocks, const LogQuery& query,
+        unsigned threads, std::uint64_t blockSize = LOGINDEX_BLOCK_SIZE);
+
+} /* namespace logging */
+
+#endif /* LOGGING_LOGQUERY_H_ */
+/** @} */
@@ -25,8 +25,8 @@ enum class LogLevel;
 /**
  * Size of the internal buffer.
  *
- * Should be sufficient for most log messages to prevent interleaved output
- * when multiple threads are printing.
+ * Should be sufficient for most log messages. Longer messages are collected
+ * in a std::string, so they are still handed over to the Logger in one piece.
  */
 constexpr int BUFFER_SIZE = 256;
 
@@ -46,10 +46,13 @@ private:
     const LogLevel& logLevel; ///< LogLevel of the current message
     std::string module; ///< the module of the current message
     char buffer[BUFFER_SIZE]; ///< buffer for the message
+    std::string overflowBuffer; ///< beginning of a message longer than buffer
 public:
     LogRecord(Logger& logger, const LogLevel& logLevel, const std::string& module);
     ~LogRecord();
 
+    LogRecord& writePrefix(unsigned samplingRate, const std::string& prefix);
+
     virtual int overflow(int ch) override;
     virtual int sync() override;
 
@@ -14,10 +14,14 @@
 #ifndef LOGGING_LOGSCOPE_H_
 #define LOGGING_LOGSCOPE_H_
 
+#include <atomic>
 #include <string>
 
 namespace logging {
 
+// forward declarations
+class Logger;
+
 /**
  * Convenient way to log scopes.
  *
@@ -30,14 +34,15 @@ namespace logging {
  */
 class LogScope {
 private:
+    Logger& logger; ///< the Logger to log to
     const char *file;   ///< the file where LOG_SCOPE; macro is called
     const char *function;   ///< the function where LOG_SCOPE macro is called
     int line; ///< the line where LOG_SCOPE macro is called
     int id; ///< ID of the scope
     std::string module; ///< the module to be logging to
-    static int instanceCounter;
+    static std::atomic<int> instanceCounter;
 public:
-    LogScope(const char* file, int line, const char* function, std::string module);
+    LogScope(Logger& logger, const char* file, int line, const char* function, std::string module);
     ~LogScope();
 
 private:
@@ -0,0 +1,78 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/** 
+ * @file
+ * \addtogroup Logging
+ * @{
+ */
+
+#ifndef LOGGING_LOGSINK_H_
+#define LOGGING_LOGSINK_H_
+
+#include "logging/LogStatistics.h"
+#include <string>
+
+namespace logging {
+
+// forward declarations
+enum class LogLevel;
+
+/**
+ * Interface for additional destinations of log messages (besides std::cout
+ * and the logfile).
+ *
+ * A LogSink has its own LogLevel, the module white-/blacklist of the Logger
+ * applies as well. write() and flush() are only called with the Logger's
+ * mutex held.
+ *
+ * @author  Moritz Höwer (Moritz.Hoewer@haw-hamburg.de)
+ * @version 1.0
+ */
+class LogSink {
+private:
+    LogLevel logLevel; ///< LogLevel for printing to this sink
+public:
+    explicit LogSink(LogLevel logLevel);
+    virtual ~LogSink();
+
+    /**
+     * Delete Copy constructor
+     */
+    LogSink(const LogSink&) = delete;
+
+    /**
+     * Delete Copy assignment
+     */
+    LogSink& operator=(const LogSink&) = delete;
+
+    LogLevel getLogLevel() const;
+
+    /**
+     * Write a (complete) log message.
+     *
+     * @param message the formatted message, including the trailing newline
+     * @param logLevel the LogLevel of the message
+     * @param module the module of the message
+     */
+    virtual void write(const std::string& message, const LogLevel& logLevel,
+            const std::string& module) = 0;
+
+    virtual void flush();
+
+    /**
+     * @return the name of the sink (used in the statistics)
+     */
+    virtual std::string getName() const = 0;
+
+    virtual SinkStatistics stats() const;
+};
+
+} /* namespace logging */
+
+#endif /* LOGGING_LOGSINK_H_ */
+/** @} */
@@ -0,0 +1,149 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/** 
+ * @file
+ * \addtogroup Logging
+ * @{
+ */
+
+#ifndef LOGGING_LOGSTATISTICS_H_
+#define LOGGING_LOGSTATISTICS_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+namespace logging {
+
+// forward declarations
+enum class LogLevel;
+
+/**
+ * Number of LogLevels that can be attached to a message (all but OFF)
+ */
+constexpr int NUM_LOGLEVELS = 5;
+
+/**
+ * Assumed size of a cache line, used to keep the counters of different
+ * threads apart.
+ */
+constexpr int CACHE_LINE_SIZE = 64;
+
+/**
+ * Snapshot of the statistics of a single sink.
+ */
+struct SinkStatistics {
+    std::uint64_t writes = 0; ///< number of messages written
+    std::uint64_t bytes = 0; ///< number of bytes written
+    std::uint64_t dropped = 0; ///< number of messages that could not be written
+    std::chrono::nanoseconds writeTime { 0 }; ///< time spent writing
+
+    SinkStatistics& operator+=(const SinkStatistics& other);
+};
+
+/**
+ * Snapshot of the statistics of a Logger.
+ */
+struct LogStatistics {
+    std::array<std::uint64_t, NUM_LOGLEVELS> records; ///< printed messages per LogLevel
+    std::map<std::string, std::uint64_t> moduleRecords; ///< printed messages per module
+    std::uint64_t filtered = 0; ///< messages that were filtered
+    std::uint64_t sampledOut = 0; ///< messages that were skipped by sampling
+    std::uint64_t shed = 0; ///< messages that were dropped because of overload
+    std::map<std::string, SinkStatistics> sinks; ///< statistics per sink
+
+    LogStatistics();
+};
+std::ostream& operator<<(std::ostream& os, const LogStatistics& stats);
+
+/**
+ * Counters for the Logger's self-instrumentation.
+ *
+ * The counters are sharded: every thread updates its own cache line padded
+ * shard, so counting does not make threads contend with each other. The
+ * shards are only summed up when a snapshot is requested.
+ *
+ * @author  Moritz Höwer (Moritz.Hoewer@haw-hamburg.de)
+ * @version 1.0
+ */
+class LogCounters {
+public:
+    /**
+     * The built-in sinks of the Logger
+     */
+    enum Sink {
+        SINK_COUT, SINK_FILE, NUM_SINKS
+    };
+
+private:
+    /**
+     * Number of shards, threads are distributed round robin
+     */
+    static constexpr int NUM_SHARDS = 16;
+
+    /**
+     * Counters of a single sink
+     */
+    struct SinkCounters {
+        std::atomic<std::uint64_t> writes;
+        std::atomic<std::uint64_t> bytes;
+        std::atomic<std::uint64_t> writeTime; ///< in ns
+    };
+
+    /**
+     * The counters updated by one group of threads
+     */
+    struct Shard {
+        std::atomic<std::uint64_t> records[NUM_LOGLEVELS];
+        std::atomic<std::uint64_t> filtered;
+        std::atomic<std::uint64_t> sampledOut;
+        std::atomic<std::uint64_t> shed;
+        SinkCounters sinks[NUM_SINKS];
+        mutable std::mutex moduleMutex; ///< guards moduleRecords
+        std::map<std::string, std::uint64_t> moduleRecords;
+    };
+
+    std::unique_ptr<char[]> storage; ///< memory of the shards
+    Shard* shards[NUM_SHARDS]; ///< the shards, each starting on its own cache line
+public:
+    LogCounters();
+    ~LogCounters();
+
+    /**
+     * Delete Copy constructor
+     */
+    LogCounters(const LogCounters&) = delete;
+
+    /**
+     * Delete Copy assignment
+     */
+    LogCounters& operator=(const LogCounters&) = delete;
+
+    void countRecord(const LogLevel& logLevel, const std::string& module);
+    void countFiltered();
+    void countSampledOut();
+    void countShed();
+    void countWrite(Sink sink, std::size_t bytes,
+            std::chrono::nanoseconds writeTime);
+
+    LogStatistics snapshot() const;
+
+private:
+    Shard& getShard();
+};
+
+} /* namespace logging */
+
+#endif /* LOGGING_LOGSTATISTICS_H_ */
+/** @} */
@@ -18,13 +18,21 @@
 //#define ENABLE_INITIALIZER_LIST_WORKAROUND
 
 #include "logging/LogRecord.h"
+#include "logging/LogStatistics.h"
+#include "logging/LogSink.h"
+#include <atomic>
 #include <string>
 #include <fstream>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 namespace logging {
 
+// forward declarations
+class LogIndexBuilder;
+
 /**
  * Defines the levels of severity in decreasing order
  */
@@ -33,6 +41,14 @@ enum class LogLevel {
 };
 std::ostream& operator<<(std::ostream& os, const LogLevel& ll);
 
+/**
+ * Sampling rate of a message, printed as [1/N] for sampled messages
+ */
+struct SamplingRate {
+    unsigned rate; ///< 1 in rate messages is printed
+};
+std::ostream& operator<<(std::ostream& os, const SamplingRate& sr);
+
 /**
  * An implementation for a Logger
  *
@@ -44,13 +60,34 @@ private:
     LogLevel defaultCoutLogLevel; ///< default LogLevel for printing to std::cout
     LogLevel defaultFileLogLevel; ///< default LogLevel for printing to the logfile
     std::ofstream file; ///< handle to the logfile
+    std::ofstream indexFile; ///< handle to the index of the logfile
+    std::unique_ptr<LogIndexBuilder> indexBuilder; ///< builds the index, if one is written
     std::map<std::string, std::tuple<LogLevel, LogLevel>> logLevels; ///< LogLevels per module
+    std::map<std::string, std::array<unsigned, NUM_LOGLEVELS>> samplingRates; ///< sampling rates per module and LogLevel
     std::vector<std::string> moduleList; ///< white or blacklist of modules, determined by moduleListIsWhitelist
     bool moduleListIsWhitelist; ///< is the module list a whitelist
+    std::vector<std::shared_ptr<LogSink>> sinks; ///< additional sinks
+    std::vector<SinkStatistics> sinkStatistics; ///< writes to the additional sinks (guarded by mutex)
+    std::atomic<int> sinksLogLevel; ///< least severe LogLevel of all additional sinks
+    mutable std::mutex mutex; ///< serializes writing to the sinks
+    mutable LogCounters counters; ///< self-instrumentation
+    std::atomic<std::int64_t> statisticsInterval; ///< interval for logging the statistics in ns, 0 = off
+    std::atomic<std::int64_t> nextStatistics; ///< when to log the statistics next (steady_clock, in ns)
+    std::atomic<int> overloadLogLevel; ///< least severe LogLevel printed during overload (TRACE = no overload)
+    std::chrono::nanoseconds overloadHighLatency; ///< average write latency considered overload, 0 = off
+    std::chrono::nanoseconds overloadLowLatency; ///< average write latency considered recovered
+    std::chrono::milliseconds overloadHoldTime; ///< minimum time between changes of overloadLogLevel
+    std::chrono::nanoseconds averageWriteLatency; ///< moving average of the write latency
+    std::chrono::steady_clock::time_point lastOverloadChange; ///< when overloadLogLevel changed last
+    std::chrono::steady_clock::time_point lastWrite; ///< when a message was written last
+    std::atomic<std::int64_t> nextOverloadProbe; ///< when to probe for recovery next (steady_clock, in ns)
 public:
-    static Logger& getLogger(); // Singleton
+    static Logger& getLogger(); // default Logger
 
 public:
+    Logger();
+    ~Logger();
+
     /**
      * Delete Copy constructor
      */
@@ -62,13 +99,24 @@ public:
     Logger& operator=(const Logger&) = delete;
 
     LogRecord startLog(const LogLevel& logLevel, const std::string& module);
+    bool isEnabled(const LogLevel& logLevel, const std::string& module);
+    unsigned sample(const LogLevel& logLevel, const std::string& module);
     void log(const std::string& message, const LogLevel& logLevel, const std::string& module);
 
     void setDefaultCoutLogLevel(LogLevel defaultCoutLogLevel);
     void setDefaultFileLogLevel(LogLevel defaultFileLogLevel);
-    void setLogfile(std::string filename);
+    void setLogfile(std::string filename, bool index = false);
+    void addSink(std::shared_ptr<LogSink> sink);
+    void flush();
 
     void setLogLevelsForModule(const std::string& module, LogLevel coutLogLevel, LogLevel fileLogLevel);
+    void setSamplingRateForModule(const std::string& module, LogLevel logLevel, unsigned rate);
+
+    LogStatistics stats() const;
+    void setStatisticsInterval(std::chrono::milliseconds interval);
+    void setOverloadProtection(std::chrono::nanoseconds highLatency,
+            std::chrono::nanoseconds lowLatency,
+            std::chrono::milliseconds holdTime);
 
 #ifdef ENABLE_INITIALIZER_LIST_WORKAROUND
     template<typename T = std::string, typename... Targs>
@@ -83,12 +131,27 @@ public:
     void setModuleBlacklist(std::initializer_list<std::string> modules);
 #endif
 private:
-    Logger();
-
+    void closeLogfile();
+    void writeIndexBlocks();
+    void getTargets(const LogLevel& logLevel, const std::string& module,
+            bool& logCout, bool& logFile, bool& logSinks) const;
+    void logStatisticsIfDue(std::chrono::steady_clock::time_point now);
+    bool adaptToOverload(std::chrono::nanoseconds latency,
+            std::chrono::steady_clock::time_point now);
+    void probeOverload();
+    void logOverload(std::chrono::nanoseconds averageLatency);
 };
 
+/**
+ * Size of a buffer sufficient for formatTimeSinceStart()
+ */
+constexpr int TIME_BUFFER_SIZE = 24;
+
+std::size_t formatTimeSinceStart(char* buffer);
 std::string getTimeSinceStart();
 const char* getRelativePath(const char *absolutePath);
+std::string makeLogPrefix(const char* levelTag, const std::string& module,
+        const char* file, int line, const char* function);
 
 #ifdef ENABLE_INITIALIZER_LIST_WORKAROUND
 /**
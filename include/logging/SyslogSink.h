@@ -0,0 +1,97 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/** 
+ * @file
+ * \addtogroup Logging
+ * @{
+ */
+
+#ifndef LOGGING_SYSLOGSINK_H_
+#define LOGGING_SYSLOGSINK_H_
+
+#include "logging/LogSink.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace logging {
+
+/**
+ * Sends every log message as one datagram over a local (AF_UNIX) socket.
+ *
+ * Messages are either formatted according to RFC 5424 (for syslog, e.g.
+ * /dev/log) or using the native journald protocol (e.g.
+ * /run/systemd/journal/socket). They are collected and sent in batches; a
+ * batch is sent when it is full, when a WARNING or ERROR is logged, when its
+ * oldest message has waited for maxDelay, or when the sink is flushed.
+ * Sending never blocks: messages the receiver can't take right now are
+ * dropped and counted.
+ *
+ * @author  Moritz Höwer (Moritz.Hoewer@haw-hamburg.de)
+ * @version 1.0
+ */
+class SyslogSink : public LogSink {
+public:
+    /**
+     * Format of the datagrams
+     */
+    enum class Format {
+        RFC5424, JOURNALD
+    };
+
+private:
+    std::string path; ///< path of the socket to send to
+    Format format; ///< format of the datagrams
+    std::string appName; ///< APP-NAME / SYSLOG_IDENTIFIER
+    std::string hostname; ///< HOSTNAME (RFC 5424 only)
+    unsigned batchSize; ///< maximum number of datagrams per batch
+    std::chrono::milliseconds maxDelay; ///< maximum time a datagram waits in the batch, 0 = no limit
+    int socket; ///< the socket, -1 if not connected
+    std::vector<std::string> batch; ///< datagrams waiting to be sent
+    std::chrono::steady_clock::time_point oldest; ///< when the first datagram of the batch was queued
+    std::mutex mutex; ///< protects socket and batch against the flusher
+    std::condition_variable wakeup; ///< wakes the flusher
+    bool stopping; ///< tells the flusher to exit
+    std::atomic<std::uint64_t> writes; ///< datagrams sent
+    std::atomic<std::uint64_t> bytes; ///< bytes sent
+    std::atomic<std::uint64_t> dropped; ///< datagrams dropped
+    std::atomic<std::uint64_t> writeTime; ///< time spent sending in ns
+    std::thread flusher; ///< sends batches that have waited for maxDelay
+public:
+    SyslogSink(const std::string& path, LogLevel logLevel,
+            Format format = Format::RFC5424, const std::string& appName =
+                    "logging", unsigned batchSize = 16,
+            std::chrono::milliseconds maxDelay = std::chrono::milliseconds(
+                    100));
+    virtual ~SyslogSink();
+
+    virtual void write(const std::string& message, const LogLevel& logLevel,
+            const std::string& module) override;
+    virtual void flush() override;
+    virtual std::string getName() const override;
+    virtual SinkStatistics stats() const override;
+
+private:
+    bool connect();
+    void sendBatch();
+    void runFlusher();
+    std::string formatRFC5424(const std::string& message,
+            const LogLevel& logLevel, const std::string& module) const;
+    std::string formatJournald(const std::string& message,
+            const LogLevel& logLevel, const std::string& module) const;
+};
+
+} /* namespace logging */
+
+#endif /* LOGGING_SYSLOGSINK_H_ */
+/** @} */
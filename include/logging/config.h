@@ -30,6 +30,16 @@
 #define LOGFILE_HEADER 			"Change this in include/logging/config.h"
 #define LOGFILE_SHOW_BUILD		1
 
+/*
+ * Configure module used for logging the Logger's statistics
+ */
+#define STATISTICS_MODULE		"LOGGING"
+
+/*
+ * Configure module used for logging overload of the sinks
+ */
+#define OVERLOAD_MODULE			"LOGGING"
+
 /*
  * Configure color here
  */
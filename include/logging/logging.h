@@ -15,6 +15,8 @@
 #include "logging/LogScope.h"
 #include "logging/LogRecord.h"
 #include "logging/Logger.h"
+#include "logging/LazyArgument.h"
+#include "logging/SyslogSink.h"
 
 using namespace logging;
 
@@ -29,20 +31,42 @@ using namespace logging;
     #define LOG_MODULE GLOBAL_MODULE
 #endif
 
-// Print the location [File:line (Function)]
-#define LOGMESSAGE_LOCATION "[" << getRelativePath(__FILE__) << ":" << __LINE__ << " (" << __FUNCTION__ << ")]: "
+// The constant part of the prefix [LEVEL][Module][File:line (Function)]:
+// Built once per call site (so LOG_MODULE must not change at runtime)
+#define LOGMESSAGE_PREFIX(MESSAGE) \
+    [](const char* function) -> const std::string& { \
+        static const std::string prefix = makeLogPrefix(MESSAGE, LOG_MODULE, getRelativePath(__FILE__), __LINE__, function); \
+        return prefix; \
+    }(__FUNCTION__)
+
+// No Logger = default Logger
+#ifndef LOG_LOGGER
+    #define LOG_LOGGER Logger::getLogger()
+#endif
 
 // Get a LogRecord (get the Logger, create a LogRecord, set log level)
-#define GET_LOG_RECORD(LEVEL, MODULE) \
-	Logger::getLogger().startLog(LogLevel::LEVEL, MODULE)
+#define GET_LOG_RECORD(LOGGER, LEVEL, MODULE) \
+	(LOGGER).startLog(LogLevel::LEVEL, MODULE)
+
+// Check if a log would be printed (the if/else keeps a following else intact)
+#define IF_LOG_ENABLED(LOGGER, LEVEL, MODULE) \
+    if (!(LOGGER).isEnabled(LogLevel::LEVEL, MODULE)) {} else
+
+// Check if a log would be printed, taking sampling into account
+// (runs the following statement at most once, with logSamplingRate set)
+#define IF_LOG_SAMPLED(LOGGER, LEVEL, MODULE) \
+    for (unsigned logSamplingRate = (LOGGER).sample(LogLevel::LEVEL, MODULE); \
+            logSamplingRate != 0; logSamplingRate = 0)
 
-// Prepare a log (Get a LogRecord, print time and print location)
-#define PREPARE_LOG(LEVEL, MESSAGE) \
-     GET_LOG_RECORD(LEVEL, LOG_MODULE) << "[" << getTimeSinceStart() << "]" << MESSAGE << "[" << LOG_MODULE << "]" << LOGMESSAGE_LOCATION
+// Prepare a log (Get a LogRecord, print time and the cached prefix)
+// Nothing is formatted or evaluated if the log would be filtered anyway
+#define PREPARE_LOG(LOGGER, LEVEL, MESSAGE) \
+    IF_LOG_SAMPLED(LOGGER, LEVEL, LOG_MODULE) \
+     GET_LOG_RECORD(LOGGER, LEVEL, LOG_MODULE).writePrefix(logSamplingRate, LOGMESSAGE_PREFIX(MESSAGE))
 
 
-#define PRINT_SCOPED_LOG(MODULE) \
-    GET_LOG_RECORD(TRACE, (MODULE)) << "[" << getTimeSinceStart() << "]" << "[ TRACE ]" << "[" << (MODULE) << "]"
+#define PRINT_SCOPED_LOG(LOGGER, MODULE) \
+    GET_LOG_RECORD(LOGGER, TRACE, (MODULE)) << "[" << getTimeSinceStart() << "]" << "[ TRACE ]" << "[" << (MODULE) << "]"
 
 /**
  *  \addtogroup Logging
@@ -54,38 +78,83 @@ using namespace logging;
  * Logs an error message
  */
 #define LOG_ERROR \
-    PREPARE_LOG(ERROR, "[ ERROR ]")
+    LOG_ERROR_TO(LOG_LOGGER)
 
 /**
  * Logs a warning
  */
 #define LOG_WARNING \
-		PREPARE_LOG(WARNING, "[WARNING]")
+    LOG_WARNING_TO(LOG_LOGGER)
 
 /**
  * Logs an info message
  */
 #define LOG_INFO \
-    PREPARE_LOG(INFO, "[  INFO ]")
+    LOG_INFO_TO(LOG_LOGGER)
 
 /**
  * Logs a debug message
  */
 #define LOG_DEBUG \
-    PREPARE_LOG(DEBUG, "[ DEBUG ]")
+    LOG_DEBUG_TO(LOG_LOGGER)
 
 /**
  * Logs a tracing message
  */
 #define LOG_TRACE \
-    PREPARE_LOG(TRACE, "[ TRACE ]")
+    LOG_TRACE_TO(LOG_LOGGER)
+
+// Prepare log for the different LogLevels using a specific Logger
+// (LOGGER is evaluated more than once, pass a reference or a name)
+/**
+ * Logs an error message to a specific Logger
+ */
+#define LOG_ERROR_TO(LOGGER) \
+    PREPARE_LOG(LOGGER, ERROR, "[ ERROR ]")
+
+/**
+ * Logs a warning to a specific Logger
+ */
+#define LOG_WARNING_TO(LOGGER) \
+		PREPARE_LOG(LOGGER, WARNING, "[WARNING]")
+
+/**
+ * Logs an info message to a specific Logger
+ */
+#define LOG_INFO_TO(LOGGER) \
+    PREPARE_LOG(LOGGER, INFO, "[  INFO ]")
+
+/**
+ * Logs a debug message to a specific Logger
+ */
+#define LOG_DEBUG_TO(LOGGER) \
+    PREPARE_LOG(LOGGER, DEBUG, "[ DEBUG ]")
+
+/**
+ * Logs a tracing message to a specific Logger
+ */
+#define LOG_TRACE_TO(LOGGER) \
+    PREPARE_LOG(LOGGER, TRACE, "[ TRACE ]")
+
+/**
+ * Wraps an expensive argument, it is only evaluated if the log is printed.
+ * Pass a callable, e.g. LOG_DEBUG << LOG_LAZY([&]{ return dumpState(); });
+ */
+#define LOG_LAZY(FUNCTION) \
+    makeLazyArgument(FUNCTION)
 
 // Wrappers for logging scope
 /**
  * Logs the current scope
  */
 #define LOG_SCOPE \
-	LogScope logscope(getRelativePath(__FILE__), __LINE__, __FUNCTION__, LOG_MODULE);
+	LOG_SCOPE_TO(LOG_LOGGER)
+
+/**
+ * Logs the current scope to a specific Logger
+ */
+#define LOG_SCOPE_TO(LOGGER) \
+	LogScope logscope(LOGGER, getRelativePath(__FILE__), __LINE__, __FUNCTION__, LOG_MODULE);
 
 // Wrappers to easily set LogLevel and log file
 /**
@@ -106,6 +175,33 @@ using namespace logging;
 #define SET_LOGFILE(filename) \
     Logger::getLogger().setLogfile(filename)
 
+/**
+ * Globally sets/changes logfile and writes an index for logquery alongside
+ */
+#define SET_LOGFILE_INDEXED(filename) \
+    Logger::getLogger().setLogfile(filename, true)
+
+/**
+ * Logs the Logger's statistics every INTERVAL (std::chrono::milliseconds),
+ * 0 turns it off
+ */
+#define SET_STATISTICS_INTERVAL(INTERVAL) \
+    Logger::getLogger().setStatisticsInterval(INTERVAL)
+
+/**
+ * Globally enables protection against overloaded sinks: if writing takes
+ * longer than HIGH on average, TRACE, DEBUG and INFO are dropped step by step
+ * until it's below LOW again (std::chrono durations)
+ */
+#define SET_OVERLOAD_PROTECTION(HIGH, LOW, HOLD_TIME) \
+    Logger::getLogger().setOverloadProtection(HIGH, LOW, HOLD_TIME)
+
+/**
+ * Adds an additional sink (std::shared_ptr<LogSink>)
+ */
+#define ADD_LOG_SINK(sink) \
+    Logger::getLogger().addSink(sink)
+
 
 // Wrappers for configuring modules
 /**
@@ -114,6 +210,13 @@ using namespace logging;
 #define SET_LOGLEVELS_MODULE(MODULE, COUT, FILE) \
     Logger::getLogger().setLogLevelsForModule(MODULE, COUT, FILE)
 
+/**
+ * Sets a sampling rate for a specific module and LogLevel (1 in RATE messages
+ * is printed)
+ */
+#define SET_SAMPLING_RATE_MODULE(MODULE, LEVEL, RATE) \
+    Logger::getLogger().setSamplingRateForModule(MODULE, LEVEL, RATE)
+
 
 #ifdef ENABLE_INITIALIZER_LIST_WORKAROUND
 /**
@@ -14,6 +14,7 @@ int main() {
 	LOG_INFO << "Message 3" << std::endl;
 	LOG_WARNING << "Message 4" << std::endl;
 	LOG_ERROR << "Message 5" << std::endl;
+	LOG_TRACE << "Lazy " << LOG_LAZY([]{ return 6; }) << std::endl;
 	
 	std::this_thread::sleep_for(std::chrono::seconds(1));
 	LOG_INFO << "Done sleeping..." << std::endl;
@@ -0,0 +1,442 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/** 
+ * @file
+ * \addtogroup Logging
+ * @{
+ */
+
+#include "logging/LogIndex.h"
+#include "logging/Logger.h"
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace logging {
+
+/**
+ * First bytes of an index file
+ */
+static const char LOGINDEX_MAGIC[8] = { 'C', 'X', 'X', 'L', 'O', 'G', 'I', 'X' };
+
+/**
+ * Version of the index file format
+ */
+static constexpr std::uint32_t LOGINDEX_VERSION = 2;
+
+/**
+ * Initial value of a block checksum (FNV-1a offset basis)
+ */
+static constexpr std::uint64_t CHECKSUM_SEED = 14695981039346656037u;
+
+/**
+ * The tags printed for the LogLevels, indexed by LogLevel
+ */
+static const char* const LOGLEVEL_TAGS[NUM_LOGLEVELS] = { "[ ERROR ]",
+        "[WARNING]", "[  INFO ]", "[ DEBUG ]", "[ TRACE ]" };
+
+/**
+ * Length of the tags printed for the LogLevels
+ */
+static constexpr std::size_t LOGLEVEL_TAG_LENGTH = 9;
+
+/**
+ * Constructs an empty block
+ *
+ * @param offset offset of the block in the logfile
+ */
+LogIndexBlock::LogIndexBlock(std::uint64_t offset) :
+        offset(offset), length(0), minTime(
+                std::numeric_limits<std::uint32_t>::max()), maxTime(0), logLevels(
+                0), modules(0), checksum(CHECKSUM_SEED) {
+}
+
+/**
+ * @return true if the block does not cover any bytes of the logfile
+ */
+bool LogIndexBlock::isEmpty() const {
+    return length == 0;
+}
+
+/**
+ * Check whether the block may contain messages matching a query.
+ * Modules are hashed, so the block may still not contain a matching message.
+ *
+ * @param logLevels bitmap of the LogLevels to look for
+ * @param modules bitmap of the (hashed) modules to look for
+ * @param from earliest time to look for (ms)
+ * @param to latest time to look for (ms)
+ * @return false if the block contains no matching message
+ */
+bool LogIndexBlock::mayContain(std::uint32_t logLevels, std::uint64_t modules,
+        std::uint32_t from, std::uint32_t to) const {
+    return (this->logLevels & logLevels) != 0 && (this->modules & modules) != 0
+            && minTime <= to && maxTime >= from;
+}
+
+/**
+ * Constructs a LogIndexBuilder.
+ *
+ * @param offset offset in the logfile of the first message that is added
+ * @param blockSize minimum size of a block
+ */
+LogIndexBuilder::LogIndexBuilder(std::uint64_t offset, std::uint64_t blockSize) :
+        blockSize(blockSize), current(offset) {
+}
+
+/**
+ * Add a message (one or more complete lines) to the index.
+ * The first line is parsed, the others are considered part of the message.
+ *
+ * @param message the message as written to the logfile
+ * @param length the length of the message
+ */
+void LogIndexBuilder::add(const char* message, std::size_t length) {
+    LogLine line;
+    if (parseLogLine(message, message + length, line)) {
+        current.logLevels |= 1u << static_cast<int>(line.logLevel);
+        current.modules |= getModuleBit(line.module, line.moduleLength);
+        if (line.time < current.minTime) {
+            current.minTime = line.time;
+        }
+        if (line.time > current.maxTime) {
+            current.maxTime = line.time;
+        }
+    }
+
+    current.length += length;
+    current.checksum = updateChecksum(current.checksum, message, length);
+    if (current.length >= blockSize) {
+        finish();
+    }
+}
+
+/**
+ * Complete the current block (if it isn't empty)
+ */
+void LogIndexBuilder::finish() {
+    if (!current.isEmpty()) {
+        blocks.push_back(current);
+        current = LogIndexBlock(current.offset + current.length);
+    }
+}
+
+/**
+ * Get the blocks completed since the last call
+ *
+ * @return the completed blocks
+ */
+std::vector<LogIndexBlock> LogIndexBuilder::takeBlocks() {
+    std::vector<LogIndexBlock> result;
+    result.swap(blocks);
+    return result;
+}
+
+/**
+ * Parse a number
+ *
+ * @param begin position of the first digit, moved behind the last digit
+ * @param end end of the input
+ * @param[out] number the parsed number
+ * @return the number of digits
+ */
+static int parseNumber(const char*& begin, const char* end,
+        std::uint32_t& number) {
+    int digits = 0;
+    number = 0;
+    while (begin < end && *begin >= '0' && *begin <= '9') {
+        number = number * 10 + (*begin - '0');
+        begin++;
+        digits++;
+    }
+    return digits;
+}
+
+/**
+ * Parse the start of a log line:
+ * [mm:ss.mmm]([1/N])[LEVEL][module]
+ *
+ * @param begin beginning of the line
+ * @param end end of the input (the line may end earlier)
+ * @param[out] line the parsed fields
+ * @return false if the line is not the first line of a log message
+ */
+bool parseLogLine(const char* begin, const char* end, LogLine& line) {
+    std::uint32_t mins;
+    std::uint32_t secs;
+    std::uint32_t ms;
+
+    // time
+    if (begin == end || *begin++ != '[' || parseNumber(begin, end, mins) == 0
+            || begin == end || *begin++ != ':'
+            || parseNumber(begin, end, secs) != 2 || begin == end
+            || *begin++ != '.' || parseNumber(begin, end, ms) != 3
+            || begin == end || *begin++ != ']') {
+        return false;
+    }
+    line.time = (mins * 60 + secs) * 1000 + ms;
+
+    // sampling rate
+    if (end - begin > 3 && std::memcmp(begin, "[1/", 3) == 0) {
+        begin = static_cast<const char*>(std::memchr(begin, ']', end - begin));
+        if (begin == nullptr) {
+            return false;
+        }
+        begin++;
+    }
+
+    // LogLevel
+    if (static_cast<std::size_t>(end - begin) < LOGLEVEL_TAG_LENGTH) {
+        return false;
+    }
+    int level = 0;
+    while (level < NUM_LOGLEVELS
+            && std::memcmp(begin, LOGLEVEL_TAGS[level], LOGLEVEL_TAG_LENGTH)
+                    != 0) {
+        level++;
+    }
+    if (level == NUM_LOGLEVELS) {
+        return false;
+    }
+    line.logLevel = static_cast<LogLevel>(level);
+    begin += LOGLEVEL_TAG_LENGTH;
+
+    // module
+    if (begin == end || *begin++ != '[') {
+        return false;
+    }
+    const char* moduleEnd = static_cast<const char*>(std::memchr(begin, ']',
+            end - begin));
+    if (moduleEnd == nullptr) {
+        return false;
+    }
+    line.module = begin;
+    line.moduleLength = moduleEnd - begin;
+    return true;
+}
+
+/**
+ * Parse a time in the format used in the logs (mm:ss.mmm, the ms are
+ * optional).
+ *
+ * @param time the time to parse
+ * @param[out] ms the time in ms
+ * @return false if time is not in the right format
+ */
+bool parseTime(const std::string& time, std::uint32_t& ms) {
+    const char* begin = time.c_str();
+    const char* end = begin + time.size();
+    std::uint32_t mins;
+    std::uint32_t secs;
+    std::uint32_t millis = 0;
+
+    if (parseNumber(begin, end, mins) == 0 || begin == end || *begin++ != ':'
+            || parseNumber(begin, end, secs) == 0) {
+        return false;
+    }
+    if (begin != end) {
+        if (*begin++ != '.') {
+            return false;
+        }
+        int digits = parseNumber(begin, end, millis);
+        if (digits == 0 || digits > 3 || begin != end) {
+            return false;
+        }
+        for (; digits < 3; digits++) {
+            millis *= 10;
+        }
+    }
+
+    ms = (mins * 60 + secs) * 1000 + millis;
+    return true;
+}
+
+/**
+ * Hash a module to a bit of the module bitmap (FNV-1a)
+ *
+ * @param module the module
+ * @param length the length of the module
+ * @return the bitmap with only the module's bit set
+ */
+std::uint64_t getModuleBit(const char* module, std::size_t length) {
+    std::uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < length; i++) {
+        hash ^= static_cast<unsigned char>(module[i]);
+        hash *= 16777619u;
+    }
+    return std::uint64_t(1) << (hash % 64);
+}
+
+/**
+ * Add data to a checksum (64 bit FNV-1a)
+ *
+ * @param checksum the checksum of the preceding data
+ * @param data the data
+ * @param length the length of the data
+ * @return the checksum including the data
+ */
+std::uint64_t updateChecksum(std::uint64_t checksum, const char* data,
+        std::size_t length) {
+    for (std::size_t i = 0; i < length; i++) {
+        checksum ^= static_cast<unsigned char>(data[i]);
+        checksum *= 1099511628211u;
+    }
+    return checksum;
+}
+
+/**
+ * Write a value in native byte order
+ *
+ * @param os the std::ostream to write to
+ * @param value the value to write
+ */
+template<typename T>
+static void writeValue(std::ostream& os, T value) {
+    os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+/**
+ * Read a value in native byte order
+ *
+ * @param is the std::istream to read from
+ * @param[out] value the value read
+ * @return false if the value could not be read completely
+ */
+template<typename T>
+static bool readValue(std::istream& is, T& value) {
+    return static_cast<bool>(is.read(reinterpret_cast<char*>(&value),
+            sizeof(T)));
+}
+
+/**
+ * Write the header of an index file
+ *
+ * @param os the std::ostream to write to
+ * @param blockSize the block size used
+ */
+void writeLogIndexHeader(std::ostream& os, std::uint64_t blockSize) {
+    os.write(LOGINDEX_MAGIC, sizeof(LOGINDEX_MAGIC));
+    writeValue(os, LOGINDEX_VERSION);
+    writeValue(os, std::uint32_t(0));
+    writeValue(os, blockSize);
+}
+
+/**
+ * Append a block to an index file
+ *
+ * @param os the std::ostream to write to
+ * @param block the block to write
+ */
+void writeLogIndexBlock(std::ostream& os, const LogIndexBlock& block) {
+    writeValue(os, block.offset);
+    writeValue(os, block.length);
+    writeValue(os, block.minTime);
+    writeValue(os, block.maxTime);
+    writeValue(os, block.logLevels);
+    writeValue(os, block.modules);
+    writeValue(os, block.checksum);
+}
+
+/**
+ * Check whether a block describes the given part of a logfile
+ *
+ * @param block the block
+ * @param data the content of the logfile
+ * @return true if the checksum of the block matches
+ */
+static bool matches(const LogIndexBlock& block, const char* data) {
+    return updateChecksum(CHECKSUM_SEED, data + block.offset, block.length)
+            == block.checksum;
+}
+
+/**
+ * Read the index file of a logfile.
+ * An incompletely written block at the end of the file is ignored. The index
+ * is rejected if it doesn't belong to the logfile (e.g. it is left over from
+ * an earlier logfile of the same name): the blocks must be contiguous, lie
+ * within the logfile and the first and last block must match its content.
+ *
+ * @param filename the index file
+ * @param data the content of the logfile
+ * @param length the length of the logfile
+ * @param[out] blocks the blocks of the index
+ * @return false if the file can't be read, is no index file or does not
+ *         belong to the logfile
+ */
+bool readLogIndex(const std::string& filename, const char* data,
+        std::size_t length, std::vector<LogIndexBlock>& blocks) {
+    std::ifstream is(filename, std::ios::binary);
+    char magic[sizeof(LOGINDEX_MAGIC)];
+    std::uint32_t version;
+    std::uint32_t reserved;
+    std::uint64_t blockSize;
+
+    if (!is.read(magic, sizeof(magic))
+            || std::memcmp(magic, LOGINDEX_MAGIC, sizeof(magic)) != 0
+            || !readValue(is, version) || version != LOGINDEX_VERSION
+            || !readValue(is, reserved) || !readValue(is, blockSize)) {
+        return false;
+    }
+
+    blocks.clear();
+    LogIndexBlock block;
+    while (readValue(is, block.offset) && readValue(is, block.length)
+            && readValue(is, block.minTime) && readValue(is, block.maxTime)
+            && readValue(is, block.logLevels) && readValue(is, block.modules)
+            && readValue(is, block.checksum)) {
+        if (block.offset > length || block.length > length - block.offset
+                || (!blocks.empty()
+                        && block.offset
+                                != blocks.back().offset + blocks.back().length)) {
+            return false;
+        }
+        blocks.push_back(block);
+    }
+    return blocks.empty()
+            || (matches(blocks.front(), data) && matches(blocks.back(), data));
+}
+
+/**
+ * Build the index of an existing logfile.
+ * Lines that are not the first line of a log message (e.g. the header of the
+ * logfile or multi-line messages) are added to the preceding message.
+ *
+ * @param data the content of the logfile
+ * @param length the length of the logfile
+ * @param blockSize minimum size of a block
+ * @return the blocks of the index
+ */
+std::vector<LogIndexBlock> buildLogIndex(const char* data, std::size_t length,
+        std::uint64_t blockSize) {
+    LogIndexBuilder builder(0, blockSize);
+    LogLine line;
+    const char* end = data + length;
+    const char* message = data;
+    const char* position = data;
+
+    while (position < end) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(position,
+                '\n', end - position));
+        lineEnd = lineEnd == nullptr ? end : lineEnd + 1;
+
+        if (position != message && parseLogLine(position, lineEnd, line)) {
+            builder.add(message, position - message);
+            message = position;
+        }
+        position = lineEnd;
+    }
+    if (message != end) {
+        builder.add(message, end - message);
+    }
+
+    builder.finish();
+    return builder.takeBlocks();
+}
+
+} /* namespace logging */
+/** @} */
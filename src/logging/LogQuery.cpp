@@ -0,0 +1,184 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * \addtogroup Logging
+ * @{
+ */
+
+#include "logging/LogQuery.h"
+#include "logging/Logger.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+namespace logging {
+
+/**
+ * Check whether a message matches the query
+ *
+ * @param line the first line of the message
+ * @return true if the message matches
+ */
+bool LogQuery::matches(const LogLine& line) const {
+    return (logLevels & (1u << static_cast<int>(line.logLevel)))
+            && line.time >= from && line.time <= to
+            && (module.empty()
+                    || (line.moduleLength == module.size()
+                            && std::memcmp(line.module, module.data(),
+                                    line.moduleLength) == 0));
+}
+
+/**
+ * Find the start of the next message (a line parseLogLine accepts), so
+ * multi-line messages are not split between blocks
+ *
+ * @param data the content of the logfile
+ * @param length the length of the logfile
+ * @param position where to start looking
+ * @return offset of the next message, length if there is none
+ */
+static std::uint64_t findMessage(const char* data, std::uint64_t length,
+        std::uint64_t position) {
+    LogLine line;
+    const char* end = data + length;
+    const char* begin = data + position;
+    if (position > 0 && data[position - 1] != '\n') { // skip the rest of the line
+        begin = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+        begin = begin == nullptr ? end : begin + 1;
+    }
+
+    while (begin < end) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(begin, '\n',
+                end - begin));
+        lineEnd = lineEnd == nullptr ? end : lineEnd + 1;
+        if (parseLogLine(begin, lineEnd, line)) {
+            break;
+        }
+        begin = lineEnd;
+    }
+    return begin - data;
+}
+
+/**
+ * Select the blocks of a logfile that have to be scanned for a query: the
+ * blocks of the index that may contain matching messages and everything
+ * behind the index. The part not indexed (yet) is split into blocks of about
+ * blockSize at message boundaries, so it is scanned by several workers, too.
+ *
+ * @param data the content of the logfile
+ * @param length the length of the logfile
+ * @param blocks the index of the logfile (may be empty)
+ * @param query the query
+ * @param blockSize size of the blocks the part not indexed is split into
+ * @return the blocks to scan, in the order of the logfile
+ */
+std::vector<LogIndexBlock> selectLogBlocks(const char* data,
+        std::size_t length, const std::vector<LogIndexBlock>& blocks,
+        const LogQuery& query, std::uint64_t blockSize) {
+    std::uint64_t modules =
+            query.module.empty() ?
+                    std::numeric_limits<std::uint64_t>::max() :
+                    getModuleBit(query.module.data(), query.module.size());
+    std::vector<LogIndexBlock> selected;
+    std::uint64_t indexed = 0;
+    for (const LogIndexBlock& block : blocks) {
+        if (block.mayContain(query.logLevels, modules, query.from, query.to)) {
+            selected.push_back(block);
+        }
+        indexed = block.offset + block.length;
+    }
+
+    while (indexed < length) {
+        std::uint64_t end = indexed + blockSize;
+        end = end >= length ? length : findMessage(data, length, end);
+        LogIndexBlock rest(indexed);
+        rest.length = end - indexed;
+        selected.push_back(rest);
+        indexed = end;
+    }
+    return selected;
+}
+
+/**
+ * Scan a block of a logfile for messages matching a query.
+ * Lines that are not the first line of a message belong to the preceding
+ * message, so blocks have to start at the start of a message.
+ *
+ * @param begin start of the block
+ * @param end end of the block
+ * @param query the query
+ * @return the matching messages
+ */
+std::string scanLogBlock(const char* begin, const char* end,
+        const LogQuery& query) {
+    std::string result;
+    LogLine line;
+    bool matching = false;
+
+    while (begin < end) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(begin, '\n',
+                end - begin));
+        lineEnd = lineEnd == nullptr ? end : lineEnd + 1;
+
+        if (parseLogLine(begin, lineEnd, line)) {
+            matching = query.matches(line);
+        }
+        if (matching) {
+            result.append(begin, lineEnd);
+        }
+        begin = lineEnd;
+    }
+    return result;
+}
+
+/**
+ * Run a query on a logfile, scanning the selected blocks with multiple
+ * threads (at most one per block)
+ *
+ * @param data the content of the logfile
+ * @param length the length of the logfile
+ * @param blocks the index of the logfile (may be empty)
+ * @param query the query
+ * @param threads the maximum number of threads to scan with
+ * @param blockSize size of the blocks the part not indexed is split into
+ * @return the matching messages, in the order of the logfile
+ */
+std::string queryLog(const char* data, std::size_t length,
+        const std::vector<LogIndexBlock>& blocks, const LogQuery& query,
+        unsigned threads, std::uint64_t blockSize) {
+    std::vector<LogIndexBlock> selected = selectLogBlocks(data, length, blocks,
+            query, blockSize);
+
+    std::vector<std::string> results(selected.size());
+    std::atomic<std::size_t> next { 0 };
+    std::vector<std::thread> workers;
+    std::size_t numWorkers = std::min<std::size_t>(threads, selected.size());
+    for (std::size_t i = 0; i < numWorkers; i++) {
+        workers.emplace_back([&]() {
+            for (std::size_t block = next++; block < selected.size(); block = next++) {
+                const char* begin = data + selected[block].offset;
+                results[block] = scanLogBlock(begin,
+                        begin + selected[block].length, query);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    std::string result;
+    for (const std::string& part : results) {
+        result += part;
+    }
+    return result;
+}
+
+} /* namespace logging */
+/** @} */
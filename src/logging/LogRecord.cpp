@@ -45,40 +45,63 @@ LogRecord::LogRecord(LogRecord&& logRecord) :
  * Destructs a LogRecord, syncing
  */
 LogRecord::~LogRecord() {
-    if (pbase() != pptr()) { // there is still something in the buffer!
+    if (pbase() != pptr() || !overflowBuffer.empty()) {
+        // there is still something in the buffer!
         sync();
     }
 }
 
+/**
+ * Writes the prefix of a log message: the time, the sampling rate (if the
+ * message is sampled) and the constant rest of the prefix, which is copied
+ * as a whole.
+ *
+ * @param samplingRate the sampling rate of the message
+ * @param prefix the constant part of the prefix (see makeLogPrefix())
+ * @return *this
+ */
+LogRecord& LogRecord::writePrefix(unsigned samplingRate,
+        const std::string& prefix) {
+    char time[TIME_BUFFER_SIZE + 2];
+    time[0] = '[';
+    std::size_t length = formatTimeSinceStart(time + 1) + 1;
+    time[length++] = ']';
+    write(time, length);
+
+    if (samplingRate > 1) {
+        *this << SamplingRate { samplingRate };
+    }
+    write(prefix.data(), prefix.size());
+    return *this;
+}
+
 /**
  * Called by the underlying streambuf if the buffer is overflowing.
- * Will pass the buffer (+ the overflowed character) to the Logger and then
- * clear the buffer.
+ * Moves the buffer (+ the overflowed character) to the overflowBuffer and then
+ * clears the buffer. The message is handed to the Logger on sync().
  *
  * @param i the character that overflowed
  */
 int LogRecord::overflow(int i) {
 
     /*
-     * convert buffer to std::string.
+     * append buffer to overflowBuffer.
      * pbase() points to beginning of the buffer, pptr() points to current char
-     * The constructor used expects pointer to the beginning of a string and
-     * the length of the string
      */
-    std::string message(pbase(), pptr() - pbase());
+    overflowBuffer.append(pbase(), pptr() - pbase());
 
     if (i != std::char_traits<char>::eof()) { // overflowed a char
-        message += std::string(1, (char) i);
+        overflowBuffer += (char) i;
     }
 
-    logger.log(message, logLevel, module);
     setp(buffer, buffer + BUFFER_SIZE); // reset buffer
     return 0;
 }
 
 /**
  * Called by the underlying streambuf when the stream is flushed.
- * Passes the buffer over to Logger and then resets it.
+ * Passes the message (overflowBuffer + buffer) over to Logger and then resets
+ * the buffers.
  */
 int LogRecord::sync() {
     /*
@@ -87,7 +110,13 @@ int LogRecord::sync() {
      * The constructor used expects pointer to the beginning of a string and
      * the length of the string
      */
-    logger.log(std::string(pbase(), pptr() - pbase()), logLevel, module);
+    if (overflowBuffer.empty()) {
+        logger.log(std::string(pbase(), pptr() - pbase()), logLevel, module);
+    } else {
+        overflowBuffer.append(pbase(), pptr() - pbase());
+        logger.log(overflowBuffer, logLevel, module);
+        overflowBuffer.clear();
+    }
     setp(buffer, buffer + BUFFER_SIZE); // reset buffer
     return 0;
 }
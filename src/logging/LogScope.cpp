@@ -19,15 +19,13 @@ namespace logging {
 /**
  * Instance counter used to provide unique ID to every scope that's loged
  */
-int LogScope::instanceCounter = 0;
+std::atomic<int> LogScope::instanceCounter { 0 };
 
 /**
  * Log entering a scope.
- * Unique ID is not 100% thread-safe, but it's no desaster if two scopes happen
- * to get the same ID by bad luck.
  */
-LogScope::LogScope(const char* file, int line, const char* function, std::string module) :
-        file(file), function(function), line(line), id(instanceCounter++), module(module) {
+LogScope::LogScope(Logger& logger, const char* file, int line, const char* function, std::string module) :
+        logger(logger), file(file), function(function), line(line), id(instanceCounter++), module(module) {
     logScope("Entering Scope");
 
 }
@@ -48,7 +46,8 @@ LogScope::~LogScope() {
  * @param message the message to print
  */
 void LogScope::logScope(std::string message) {
-    PRINT_SCOPED_LOG(module) <<"[" << file << ":" << line << " (" << function << ")]: "
+    IF_LOG_ENABLED(logger, TRACE, module)
+    PRINT_SCOPED_LOG(logger, module) <<"[" << file << ":" << line << " (" << function << ")]: "
             << message << " (" << id << ")" << std::endl;
 }
 
@@ -0,0 +1,61 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/** 
+ * @file
+ * \addtogroup Logging
+ * @{
+ */
+
+#include "logging/LogSink.h"
+#include "logging/Logger.h"
+
+namespace logging {
+
+/**
+ * Constructs a LogSink.
+ *
+ * @param logLevel the LogLevel for printing to this sink
+ */
+LogSink::LogSink(LogLevel logLevel) :
+        logLevel(logLevel) {
+}
+
+/**
+ * Destructs a LogSink
+ */
+LogSink::~LogSink() {
+}
+
+/**
+ * @return the LogLevel for printing to this sink
+ */
+LogLevel LogSink::getLogLevel() const {
+    return logLevel;
+}
+
+/**
+ * Write out any buffered messages.
+ * Does nothing by default.
+ */
+void LogSink::flush() {
+}
+
+/**
+ * Get the statistics of this sink.
+ * Returns empty statistics by default. The Logger measures the writes, bytes
+ * and time of every write() itself and only takes the dropped messages from
+ * here.
+ *
+ * @return a snapshot of the sink's counters
+ */
+SinkStatistics LogSink::stats() const {
+    return SinkStatistics();
+}
+
+} /* namespace logging */
+/** @} */
@@ -0,0 +1,218 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/** 
+ * @file
+ * \addtogroup Logging
+ * @{
+ */
+
+#include "logging/LogStatistics.h"
+#include "logging/Logger.h"
+#include <cstdint>
+#include <new>
+
+namespace logging {
+
+/**
+ * Names of the built-in sinks, indexed by LogCounters::Sink
+ */
+static const char* const SINK_NAMES[LogCounters::NUM_SINKS] = { "cout", "file" };
+
+/**
+ * Adds the statistics of another sink
+ *
+ * @param other the statistics to add
+ * @return *this
+ */
+SinkStatistics& SinkStatistics::operator+=(const SinkStatistics& other) {
+    writes += other.writes;
+    bytes += other.bytes;
+    dropped += other.dropped;
+    writeTime += other.writeTime;
+    return *this;
+}
+
+/**
+ * Constructs an empty snapshot
+ */
+LogStatistics::LogStatistics() {
+    records.fill(0);
+}
+
+/**
+ * Print the statistics to an ostream (as a single line).
+ *
+ * @param os the std::ostream to print to
+ * @param stats the statistics to print
+ *
+ * @return os
+ */
+std::ostream& operator<<(std::ostream& os, const LogStatistics& stats) {
+    os << "records:";
+    for (int i = 0; i < NUM_LOGLEVELS; i++) {
+        os << " " << static_cast<LogLevel>(i) << "=" << stats.records[i];
+    }
+    os << " filtered=" << stats.filtered << " sampled out="
+            << stats.sampledOut << " shed=" << stats.shed;
+
+    os << " modules:";
+    for (const auto& module : stats.moduleRecords) {
+        os << " " << module.first << "=" << module.second;
+    }
+
+    os << " sinks:";
+    for (const auto& sink : stats.sinks) {
+        os << " " << sink.first << "=" << sink.second.writes << "/"
+                << sink.second.bytes << "B/" << sink.second.dropped
+                << " dropped/"
+                << std::chrono::duration_cast<std::chrono::microseconds>(
+                        sink.second.writeTime).count() << "us";
+    }
+    return os;
+}
+
+/**
+ * Constructs LogCounters with all counters set to 0.
+ * The shards are placed on separate cache lines by hand: C++11 new only
+ * guarantees the default alignment, so an over-aligned member would make
+ * the Logger misaligned when it is allocated on the heap.
+ */
+LogCounters::LogCounters() {
+    constexpr std::size_t shardSize = (sizeof(Shard) + CACHE_LINE_SIZE - 1)
+            / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    storage.reset(new char[NUM_SHARDS * shardSize + CACHE_LINE_SIZE]);
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(storage.get());
+    char* base = storage.get()
+            + (CACHE_LINE_SIZE - address % CACHE_LINE_SIZE) % CACHE_LINE_SIZE;
+
+    for (int i = 0; i < NUM_SHARDS; i++) {
+        shards[i] = new (base + i * shardSize) Shard();
+        Shard& shard = *shards[i];
+        for (auto& records : shard.records) {
+            records = 0;
+        }
+        shard.filtered = 0;
+        shard.sampledOut = 0;
+        shard.shed = 0;
+        for (SinkCounters& sink : shard.sinks) {
+            sink.writes = 0;
+            sink.bytes = 0;
+            sink.writeTime = 0;
+        }
+    }
+}
+
+/**
+ * Destroys the shards, their memory is freed with storage
+ */
+LogCounters::~LogCounters() {
+    for (Shard* shard : shards) {
+        shard->~Shard();
+    }
+}
+
+/**
+ * Get the shard of the calling thread.
+ * Threads get their shard index assigned round robin on first use.
+ */
+LogCounters::Shard& LogCounters::getShard() {
+    static std::atomic<unsigned> nextShard { 0 };
+    thread_local unsigned shard = nextShard++ % NUM_SHARDS;
+    return *shards[shard];
+}
+
+/**
+ * Count a printed message
+ *
+ * @param logLevel the LogLevel of the message
+ * @param module the module of the message
+ */
+void LogCounters::countRecord(const LogLevel& logLevel,
+        const std::string& module) {
+    Shard& shard = getShard();
+    shard.records[static_cast<int>(logLevel)].fetch_add(1,
+            std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(shard.moduleMutex);
+    shard.moduleRecords[module]++;
+}
+
+/**
+ * Count a message that was filtered
+ */
+void LogCounters::countFiltered() {
+    getShard().filtered.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Count a message that was skipped by sampling
+ */
+void LogCounters::countSampledOut() {
+    getShard().sampledOut.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Count a message that was dropped because of overload
+ */
+void LogCounters::countShed() {
+    getShard().shed.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Count a write to one of the built-in sinks
+ *
+ * @param sink the sink that was written to
+ * @param bytes the number of bytes written
+ * @param writeTime the time it took to write
+ */
+void LogCounters::countWrite(Sink sink, std::size_t bytes,
+        std::chrono::nanoseconds writeTime) {
+    SinkCounters& counters = getShard().sinks[sink];
+    counters.writes.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    counters.writeTime.fetch_add(writeTime.count(), std::memory_order_relaxed);
+}
+
+/**
+ * Sums up all shards.
+ * The counters are read one after another, so the snapshot is not atomic
+ * with respect to concurrent logging.
+ *
+ * @return a snapshot of the statistics
+ */
+LogStatistics LogCounters::snapshot() const {
+    LogStatistics stats;
+
+    for (const Shard* shardPointer : shards) {
+        const Shard& shard = *shardPointer;
+        for (int i = 0; i < NUM_LOGLEVELS; i++) {
+            stats.records[i] += shard.records[i].load(std::memory_order_relaxed);
+        }
+        stats.filtered += shard.filtered.load(std::memory_order_relaxed);
+        stats.sampledOut += shard.sampledOut.load(std::memory_order_relaxed);
+        stats.shed += shard.shed.load(std::memory_order_relaxed);
+
+        for (int i = 0; i < NUM_SINKS; i++) {
+            SinkStatistics sink;
+            sink.writes = shard.sinks[i].writes.load(std::memory_order_relaxed);
+            sink.bytes = shard.sinks[i].bytes.load(std::memory_order_relaxed);
+            sink.writeTime = std::chrono::nanoseconds(
+                    shard.sinks[i].writeTime.load(std::memory_order_relaxed));
+            stats.sinks[SINK_NAMES[i]] += sink;
+        }
+
+        std::lock_guard<std::mutex> lock(shard.moduleMutex);
+        for (const auto& module : shard.moduleRecords) {
+            stats.moduleRecords[module.first] += module.second;
+        }
+    }
+    return stats;
+}
+
+} /* namespace logging */
+/** @} */
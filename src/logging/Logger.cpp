@@ -12,9 +12,11 @@
  */
 
 #include "logging/Logger.h"
+#include "logging/LogIndex.h"
 #include "logging/config.h"
 #include <chrono>
 #include <algorithm>
+#include <cstdio>
 #include <cstring>
 #include <cassert>
 
@@ -23,15 +25,34 @@ using namespace std::chrono;
 namespace logging {
 
 /**
- * Constructs a Logger
+ * Check a LogLevel against a threshold
+ *
+ * @param logLevel the LogLevel of a message
+ * @param threshold the LogLevel of a sink (OFF prints nothing)
+ * @return true if a message with logLevel is printed
+ */
+static bool isPrinted(LogLevel logLevel, LogLevel threshold) {
+    return threshold != LogLevel::OFF
+            && static_cast<int>(logLevel) <= static_cast<int>(threshold);
+}
+
+/**
+ * Constructs a Logger.
+ * Every Logger has its own configuration, logfile and sinks, so separate
+ * parts of a program can log independently of each other.
  */
 Logger::Logger() :
         defaultCoutLogLevel(DEFAULT_LOGLEVEL_COUT), defaultFileLogLevel(
-                DEFAULT_LOGLEVEL_FILE), file(), moduleListIsWhitelist(false) {
+                DEFAULT_LOGLEVEL_FILE), file(), moduleListIsWhitelist(false), sinksLogLevel(
+                static_cast<int>(LogLevel::OFF)), statisticsInterval(
+                0), nextStatistics(0), overloadLogLevel(
+                static_cast<int>(LogLevel::TRACE)), overloadHighLatency(0), overloadLowLatency(
+                0), overloadHoldTime(0), averageWriteLatency(0), nextOverloadProbe(
+                0) {
 }
 
 /**
- * Singleton implementation.
+ * Get the default Logger, used by the macros unless LOG_LOGGER is defined.
  */
 Logger& Logger::getLogger() {
     static Logger instance;
@@ -53,19 +74,96 @@ void Logger::setDefaultFileLogLevel(LogLevel defaultFileLogLevel) {
 
 }
 
+/**
+ * Destructs a Logger, completing the index of the logfile
+ */
+Logger::~Logger() {
+    closeLogfile();
+}
+
 /**
  * Sets/Changes the logfile.
  * Closes the existing logfile (if one such file exists) and then opens the
- * logfile specified by filename, overwriting it if it exists already
+ * logfile specified by filename, overwriting it if it exists already.
+ * If requested, an index of the logfile (filename + LOGINDEX_EXTENSION) is
+ * written alongside, which allows logquery to search the logfile quickly.
+ *
+ * @param filename the logfile
+ * @param index    if true, the index is written as well (otherwise an index
+ *                 left over from an earlier logfile is removed)
  */
-void Logger::setLogfile(std::string filename) {
-    file.close();
+void Logger::setLogfile(std::string filename, bool index) {
+    std::lock_guard<std::mutex> lock(mutex);
+    closeLogfile();
     file.open(filename, std::ios::trunc);
     file << LOGFILE_HEADER;
 #if LOGFILE_SHOW_BUILD
 	file <<	" - Build: " << __DATE__ << ", " << __TIME__;
 #endif
 	file << std::endl;
+
+    if (index) {
+        indexFile.open(filename + LOGINDEX_EXTENSION,
+                std::ios::trunc | std::ios::binary);
+        writeLogIndexHeader(indexFile, LOGINDEX_BLOCK_SIZE);
+        indexFile << std::flush;
+        indexBuilder.reset(new LogIndexBuilder(file.tellp()));
+    } else {
+        // an index of an earlier logfile doesn't describe this one
+        std::remove((filename + LOGINDEX_EXTENSION).c_str());
+    }
+}
+
+/**
+ * Closes the logfile and completes its index (if it is written)
+ */
+void Logger::closeLogfile() {
+    if (indexBuilder) {
+        indexBuilder->finish();
+        writeIndexBlocks();
+        indexBuilder.reset();
+        indexFile.close();
+    }
+    file.close();
+}
+
+/**
+ * Appends the completed blocks to the index of the logfile
+ */
+void Logger::writeIndexBlocks() {
+    for (const LogIndexBlock& block : indexBuilder->takeBlocks()) {
+        writeLogIndexBlock(indexFile, block);
+    }
+    indexFile << std::flush;
+}
+
+/**
+ * Adds an additional sink.
+ * Messages are printed to the sink according to its own LogLevel.
+ *
+ * @param sink the sink to add
+ */
+void Logger::addSink(std::shared_ptr<LogSink> sink) {
+    std::lock_guard<std::mutex> lock(mutex);
+    int sinkLogLevel = static_cast<int>(sink->getLogLevel());
+    int current = sinksLogLevel.load(std::memory_order_relaxed);
+    if (current == static_cast<int>(LogLevel::OFF) || sinkLogLevel > current) {
+        sinksLogLevel.store(sinkLogLevel, std::memory_order_relaxed);
+    }
+    sinks.push_back(sink);
+    sinkStatistics.push_back(SinkStatistics());
+}
+
+/**
+ * Writes out messages buffered by the sinks
+ */
+void Logger::flush() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::cout << std::flush;
+    file << std::flush;
+    for (auto& sink : sinks) {
+        sink->flush();
+    }
 }
 
 /**
@@ -80,6 +178,83 @@ LogRecord Logger::startLog(const LogLevel& logLevel,
     return LogRecord(*this, logLevel, module);
 }
 
+/**
+ * Check whether a message would be printed at all.
+ * Used by the LOG_XXX macros to skip formatting (and evaluating the arguments
+ * of) messages that would be filtered or dropped because of overload anyway.
+ *
+ * @param logLevel the LogLevel
+ * @param module the module
+ * @return true if the message is printed to std::cout or the logfile
+ */
+bool Logger::isEnabled(const LogLevel& logLevel,
+        const std::string& module) {
+    bool logCout;
+    bool logFile;
+    bool logSinks;
+
+    getTargets(logLevel, module, logCout, logFile, logSinks);
+    if (!logCout && !logFile && !logSinks) {
+        counters.countFiltered();
+        return false;
+    }
+
+    // only messages that would be printed are shed
+    if (static_cast<int>(logLevel)
+            > overloadLogLevel.load(std::memory_order_relaxed)) {
+        counters.countShed();
+        probeOverload();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Cheap thread-local pseudo random number generator (xorshift32).
+ *
+ * @return the next pseudo random number of the calling thread
+ */
+static std::uint32_t nextRandom() {
+    static std::atomic<std::uint32_t> seeds { 0x9E3779B9u };
+    thread_local std::uint32_t state = seeds.fetch_add(0x9E3779B9u) | 1u;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+/**
+ * Check whether a message would be printed, taking sampling into account.
+ * Used by the LOG_XXX macros: if a sampling rate N is set for the module and
+ * LogLevel, only 1 in N messages (chosen randomly) passes.
+ *
+ * @param logLevel the LogLevel
+ * @param module the module
+ * @return 0 if the message is filtered or skipped, otherwise the sampling
+ *         rate (1 if the message is not sampled)
+ */
+unsigned Logger::sample(const LogLevel& logLevel,
+        const std::string& module) {
+    if (!isEnabled(logLevel, module)) {
+        return 0;
+    }
+    if (samplingRates.empty()) {
+        return 1;
+    }
+
+    auto it = samplingRates.find(module);
+    if (it == samplingRates.end()) {
+        return 1;
+    }
+
+    unsigned rate = it->second[static_cast<int>(logLevel)];
+    if (rate > 1 && nextRandom() % rate != 0) {
+        counters.countSampledOut();
+        return 0;
+    }
+    return rate;
+}
+
 /**
  * Log a message.
  * Depending on the flags, message is printed to std::cout and/or logfile
@@ -92,7 +267,246 @@ void Logger::log(const std::string& message, const LogLevel& logLevel,
         const std::string& module) {
     bool logCout;
     bool logFile;
+    bool logSinks;
+
+    getTargets(logLevel, module, logCout, logFile, logSinks);
+    if (!logCout && !logFile && !logSinks) {
+        counters.countFiltered();
+        return;
+    }
+    counters.countRecord(logLevel, module);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    auto begin = steady_clock::now();
+    auto start = begin;
+    if (logCout) {
+        std::cout << message << std::flush;
+        auto end = steady_clock::now();
+        counters.countWrite(LogCounters::SINK_COUT, message.size(), end - start);
+        start = end;
+    }
+    if (logFile) {
+        file << message << std::flush;
+        if (indexBuilder) {
+            indexBuilder->add(message.data(), message.size());
+            writeIndexBlocks();
+        }
+        auto end = steady_clock::now();
+        counters.countWrite(LogCounters::SINK_FILE, message.size(), end - start);
+        start = end;
+    }
+    if (logSinks) {
+        for (std::size_t i = 0; i < sinks.size(); i++) {
+            if (isPrinted(logLevel, sinks[i]->getLogLevel())) {
+                sinks[i]->write(message, logLevel, module);
+                auto end = steady_clock::now();
+                sinkStatistics[i].writes++;
+                sinkStatistics[i].bytes += message.size();
+                sinkStatistics[i].writeTime += end - start;
+                start = end;
+            }
+        }
+    }
+    bool overloadChanged = adaptToOverload(start - begin, start);
+    nanoseconds averageLatency = averageWriteLatency;
+    lock.unlock();
+
+    if (overloadChanged) {
+        logOverload(averageLatency);
+    }
+    logStatisticsIfDue(start);
+}
+
+/**
+ * Adapts the overload LogLevel to the time it took to write a message.
+ * Keeps a moving average of the write latency: above the high watermark,
+ * one more LogLevel is dropped, below the low watermark one LogLevel less.
+ * The overload LogLevel changes at most once per hold time and never drops
+ * WARNING or ERROR.
+ *
+ * @attention must be called with the mutex held
+ *
+ * @param latency the time it took to write the message
+ * @param now the current time
+ * @return true if the overload LogLevel changed
+ */
+bool Logger::adaptToOverload(nanoseconds latency, steady_clock::time_point now) {
+    lastWrite = now;
+    if (overloadHighLatency == nanoseconds::zero()) {
+        return false;
+    }
+
+    // moving average, new value is weighted 1/8
+    averageWriteLatency += (latency - averageWriteLatency) / 8;
+
+    if (now - lastOverloadChange < overloadHoldTime) {
+        return false;
+    }
+    int level = overloadLogLevel.load(std::memory_order_relaxed);
+    if (averageWriteLatency > overloadHighLatency
+            && level > static_cast<int>(LogLevel::WARNING)) {
+        level--;
+    } else if (averageWriteLatency < overloadLowLatency
+            && level < static_cast<int>(LogLevel::TRACE)) {
+        level++;
+    } else {
+        return false;
+    }
 
+    overloadLogLevel.store(level, std::memory_order_relaxed);
+    lastOverloadChange = now;
+    return true;
+}
+
+/**
+ * Called when a message is dropped because of overload.
+ * If nothing has been written for the hold time, there is no latency to
+ * measure, so one LogLevel less is dropped to probe whether the sinks have
+ * recovered.
+ */
+void Logger::probeOverload() {
+    auto now = steady_clock::now();
+    std::int64_t current = duration_cast<nanoseconds>(now.time_since_epoch()).count();
+    if (current < nextOverloadProbe.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return;
+    }
+    nextOverloadProbe = current
+            + duration_cast<nanoseconds>(overloadHoldTime).count();
+
+    int level = overloadLogLevel.load(std::memory_order_relaxed);
+    if (now - lastWrite < overloadHoldTime
+            || now - lastOverloadChange < overloadHoldTime
+            || level >= static_cast<int>(LogLevel::TRACE)) {
+        return;
+    }
+    overloadLogLevel.store(level + 1, std::memory_order_relaxed);
+    lastOverloadChange = now;
+    averageWriteLatency = overloadLowLatency;
+    lock.unlock();
+
+    logOverload(overloadLowLatency);
+}
+
+/**
+ * Logs the current overload LogLevel (as WARNING in OVERLOAD_MODULE)
+ *
+ * @param averageLatency the average write latency that caused the change
+ */
+void Logger::logOverload(nanoseconds averageLatency) {
+    LogLevel level = static_cast<LogLevel>(overloadLogLevel.load(
+            std::memory_order_relaxed));
+
+    if (isEnabled(LogLevel::WARNING, OVERLOAD_MODULE)) {
+        startLog(LogLevel::WARNING, OVERLOAD_MODULE) << "["
+                << getTimeSinceStart() << "][WARNING][" << OVERLOAD_MODULE
+                << "]: Sinks "
+                << (level == LogLevel::TRACE ? "recovered" : "overloaded")
+                << ", printing messages up to " << level
+                << " (average write latency "
+                << duration_cast<microseconds>(averageLatency).count()
+                << "us)" << std::endl;
+    }
+}
+
+/**
+ * Enables the overload protection.
+ * If writing messages takes longer than highLatency on average, messages of
+ * the least severe LogLevel still printed are dropped (TRACE, then DEBUG,
+ * then INFO - never WARNING or ERROR). Once the average drops below
+ * lowLatency, they are printed again, one LogLevel at a time. The LogLevel
+ * changes at most once per holdTime.
+ *
+ * @param highLatency the average write latency considered overload, 0 disables
+ *                    the overload protection
+ * @param lowLatency  the average write latency considered recovered
+ * @param holdTime    minimum time between two changes
+ */
+void Logger::setOverloadProtection(nanoseconds highLatency,
+        nanoseconds lowLatency, milliseconds holdTime) {
+    std::lock_guard<std::mutex> lock(mutex);
+    overloadHighLatency = highLatency;
+    overloadLowLatency = lowLatency;
+    overloadHoldTime = holdTime;
+    averageWriteLatency = nanoseconds::zero();
+    overloadLogLevel = static_cast<int>(LogLevel::TRACE);
+}
+
+/**
+ * Logs the statistics (as INFO in STATISTICS_MODULE) if the interval set by
+ * setStatisticsInterval has elapsed.
+ * Only one thread wins the race for logging them.
+ *
+ * @param now the current time
+ */
+void Logger::logStatisticsIfDue(steady_clock::time_point now) {
+    std::int64_t interval = statisticsInterval.load(std::memory_order_relaxed);
+    if (interval == 0) {
+        return;
+    }
+
+    std::int64_t current = duration_cast<nanoseconds>(now.time_since_epoch()).count();
+    std::int64_t due = nextStatistics.load(std::memory_order_relaxed);
+    if (current < due
+            || !nextStatistics.compare_exchange_strong(due, current + interval)) {
+        return;
+    }
+
+    if (isEnabled(LogLevel::INFO, STATISTICS_MODULE)) {
+        startLog(LogLevel::INFO, STATISTICS_MODULE) << "["
+                << getTimeSinceStart() << "][  INFO ][" << STATISTICS_MODULE
+                << "]: " << stats() << std::endl;
+    }
+}
+
+/**
+ * Get the Logger's statistics.
+ *
+ * @return a snapshot of the counters
+ */
+LogStatistics Logger::stats() const {
+    LogStatistics stats = counters.snapshot();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (std::size_t i = 0; i < sinks.size(); i++) {
+        // writes are measured here, only the sink knows what it dropped
+        SinkStatistics sinkStats = sinkStatistics[i];
+        sinkStats.dropped = sinks[i]->stats().dropped;
+        stats.sinks[sinks[i]->getName()] += sinkStats; // names may repeat
+    }
+    return stats;
+}
+
+/**
+ * Sets the interval for logging the statistics.
+ * They are logged as INFO in STATISTICS_MODULE by the first message after the
+ * interval has elapsed.
+ *
+ * @param interval the interval, 0 disables logging the statistics
+ */
+void Logger::setStatisticsInterval(milliseconds interval) {
+    nextStatistics = duration_cast<nanoseconds>(
+            (steady_clock::now() + interval).time_since_epoch()).count();
+    statisticsInterval = duration_cast<nanoseconds>(interval).count();
+}
+
+/**
+ * Determine where a message should be printed.
+ * Applies the module white-/blacklist and the (module specific) LogLevels.
+ *
+ * @param logLevel the LogLevel
+ * @param module the module
+ * @param[out] logCout set to true if message should be printed to std::cout
+ * @param[out] logFile set to true if message should be printed to the logfile
+ * @param[out] logSinks set to true if message should be printed to (at least
+ *                      one of) the additional sinks
+ */
+void Logger::getTargets(const LogLevel& logLevel, const std::string& module,
+        bool& logCout, bool& logFile, bool& logSinks) const {
     // check if module is in the list
     bool inList = std::find(moduleList.begin(), moduleList.end(), module)
             != moduleList.end();
@@ -103,24 +517,21 @@ void Logger::log(const std::string& message, const LogLevel& logLevel,
         LogLevel coutLogLevel = defaultCoutLogLevel;
         LogLevel fileLogLevel = defaultFileLogLevel;
 
-        if (logLevels.find(module) != logLevels.end()) {
+        auto it = logLevels.find(module);
+        if (it != logLevels.end()) {
             // specific log levels are set
-            std::tie(coutLogLevel, fileLogLevel) = logLevels[module];
+            std::tie(coutLogLevel, fileLogLevel) = it->second;
         }
 
-        logCout = static_cast<int>(logLevel) <= static_cast<int>(coutLogLevel);
-        logFile = static_cast<int>(logLevel) <= static_cast<int>(fileLogLevel);
+        logCout = isPrinted(logLevel, coutLogLevel);
+        logFile = file.is_open() && isPrinted(logLevel, fileLogLevel);
+        logSinks = isPrinted(logLevel, static_cast<LogLevel>(
+                sinksLogLevel.load(std::memory_order_relaxed)));
 
     } else {
         logCout = false;
         logFile = false;
-    }
-
-    if (logCout) {
-        std::cout << message << std::flush;
-    }
-    if (logFile) {
-        file << message << std::flush;
+        logSinks = false;
     }
 }
 
@@ -136,6 +547,33 @@ void Logger::setLogLevelsForModule(const std::string& module,
     logLevels[module] = std::make_tuple(coutLogLevel, fileLogLevel);
 }
 
+/**
+ * Sets a sampling rate for a specific module and LogLevel.
+ * Only 1 in rate messages (chosen randomly) will be printed, they are marked
+ * with [1/rate] so the real number of messages can be estimated.
+ *
+ * @param module   the module to set the sampling rate for
+ * @param logLevel the LogLevel to set the sampling rate for
+ * @param rate     the sampling rate, 1 (or 0) prints every message
+ */
+void Logger::setSamplingRateForModule(const std::string& module,
+        LogLevel logLevel, unsigned rate) {
+    if (logLevel == LogLevel::OFF) {
+        return; // messages are never logged with LogLevel OFF
+    }
+    if (rate == 0) {
+        rate = 1; // 0 would drop every message without counting it
+    }
+
+    auto it = samplingRates.find(module);
+    if (it == samplingRates.end()) {
+        std::array<unsigned, NUM_LOGLEVELS> rates;
+        rates.fill(1);
+        it = samplingRates.insert(std::make_pair(module, rates)).first;
+    }
+    it->second[static_cast<int>(logLevel)] = rate;
+}
+
 #ifdef ENABLE_INITIALIZER_LIST_WORKAROUND
 /**
  * Ends the recursion for adding modules to whitelist.
@@ -197,39 +635,77 @@ static int getCurrentMS() {
 }
 
 /**
- * pad the a number with 0
+ * write a number padded with 0
  *
- * @param number the number to pad
- * @param digits the number of digits
- * @return a string with the padded number
+ * @param buffer where to write the number
+ * @param number the number to write (not negative)
+ * @param digits the minimum number of digits
+ * @return pointer behind the last digit written
  */
-static std::string padNumber(int number, int digits) {
-    std::string result = std::to_string(number);
-
-    int ref = 1;
-
-    for (digits--; digits > 0; digits--) {
-        ref *= 10;
-        if (number < ref) {
-            result = "0" + result;
-        }
+static char* writePaddedNumber(char* buffer, int number, int digits) {
+    char reversed[16];
+    int length = 0;
+
+    do {
+        reversed[length++] = '0' + number % 10;
+        number /= 10;
+    } while (number > 0);
+    for (; length < digits; digits--) {
+        *buffer++ = '0';
+    }
+    while (length > 0) {
+        *buffer++ = reversed[--length];
     }
-    return result;
+    return buffer;
 }
 
 /**
- * Returns time since program start.
+ * Writes the time since program start to a buffer.
  * the format is mm:ss.msmsms (eg. 00:00.310 / 02:10.000)
+ *
+ * @param buffer where to write the time, at least TIME_BUFFER_SIZE chars
+ * @return the number of chars written
  */
-std::string getTimeSinceStart() {
+std::size_t formatTimeSinceStart(char* buffer) {
     int ms = getCurrentMS();
     int secs = ms / 1000;
     int mins = secs / 60;
     secs = secs % 60;
     ms = ms % 1000;
 
-    return padNumber(mins, 2) + ":" + padNumber(secs, 2) + "."
-            + padNumber(ms, 3);
+    char* end = writePaddedNumber(buffer, mins, 2);
+    *end++ = ':';
+    end = writePaddedNumber(end, secs, 2);
+    *end++ = '.';
+    end = writePaddedNumber(end, ms, 3);
+    return end - buffer;
+}
+
+/**
+ * Returns time since program start.
+ * the format is mm:ss.msmsms (eg. 00:00.310 / 02:10.000)
+ */
+std::string getTimeSinceStart() {
+    char buffer[TIME_BUFFER_SIZE];
+    return std::string(buffer, formatTimeSinceStart(buffer));
+}
+
+/**
+ * Builds the constant part of the prefix of a log message:
+ * [LEVEL][module][file:line (function)]:
+ * The LOG_XXX macros build it only once per call site.
+ *
+ * @param levelTag the LogLevel as printed (eg. "[ ERROR ]")
+ * @param module the module
+ * @param file the (relative) file
+ * @param line the line
+ * @param function the function
+ * @return the prefix
+ */
+std::string makeLogPrefix(const char* levelTag, const std::string& module,
+        const char* file, int line, const char* function) {
+    return levelTag + ("[" + module + "][") + file + ":" + std::to_string(line)
+            + " (" + function + ")]: ";
 }
 
 /**
@@ -277,5 +753,21 @@ std::ostream& operator <<(std::ostream& os, const LogLevel& ll) {
     return os;
 }
 
+/**
+ * Print the SamplingRate to an ostream.
+ * Nothing is printed for messages that are not sampled.
+ *
+ * @param os the std::ostream to print to
+ * @param sr the SamplingRate to print
+ *
+ * @return os
+ */
+std::ostream& operator <<(std::ostream& os, const SamplingRate& sr) {
+    if (sr.rate > 1) {
+        os << "[1/" << sr.rate << "]";
+    }
+    return os;
+}
+
 } /* namespace logging */
 /** @} */
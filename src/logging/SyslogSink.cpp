@@ -0,0 +1,405 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/** 
+ * @file
+ * \addtogroup Logging
+ * @{
+ */
+
+#include "logging/SyslogSink.h"
+#include "logging/Logger.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <utility>
+
+using namespace std::chrono;
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // SO_NOSIGPIPE is set instead
+#endif
+
+namespace logging {
+
+/**
+ * syslog facility "user-level messages"
+ */
+static constexpr int FACILITY_USER = 1;
+
+/**
+ * Map a LogLevel to a syslog severity
+ *
+ * @param logLevel the LogLevel
+ * @return the severity (3 = error ... 7 = debug)
+ */
+static int getSeverity(const LogLevel& logLevel) {
+    switch (logLevel) {
+    case LogLevel::ERROR:
+        return 3;
+    case LogLevel::WARNING:
+        return 4;
+    case LogLevel::INFO:
+        return 6;
+    default:
+        return 7;
+    }
+}
+
+/**
+ * Remove the trailing newline of a message
+ *
+ * @param message the message
+ * @return the length of message without trailing newlines
+ */
+static std::size_t getTrimmedLength(const std::string& message) {
+    std::size_t length = message.size();
+    while (length > 0 && message[length - 1] == '\n') {
+        length--;
+    }
+    return length;
+}
+
+/**
+ * Maximum length of the MSGID field (RFC 5424)
+ */
+static constexpr std::size_t MAX_MSGID_LENGTH = 32;
+
+/**
+ * Map a module to a valid MSGID: at most 32 printable US-ASCII characters
+ * without spaces, other characters are replaced by '_'
+ *
+ * @param module the module
+ * @return the MSGID ("-" for no module)
+ */
+static std::string getMsgId(const std::string& module) {
+    if (module.empty()) {
+        return "-";
+    }
+    std::string msgId = module.substr(0, MAX_MSGID_LENGTH);
+    for (char& c : msgId) {
+        if (c < 33 || c > 126) { // also catches bytes of UTF-8 sequences
+            c = '_';
+        }
+    }
+    return msgId;
+}
+
+/**
+ * Constructs a SyslogSink and connects to the socket.
+ * If the socket can't be connected yet, connecting is retried on every flush.
+ *
+ * @param path path of the socket to send to
+ * @param logLevel the LogLevel for printing to this sink
+ * @param format format of the datagrams
+ * @param appName APP-NAME (RFC 5424) / SYSLOG_IDENTIFIER (journald)
+ * @param batchSize maximum number of datagrams to send at once
+ */
+SyslogSink::SyslogSink(const std::string& path, LogLevel logLevel,
+        Format format, const std::string& appName, unsigned batchSize,
+        milliseconds maxDelay) :
+        LogSink(logLevel), path(path), format(format), appName(appName), hostname(
+                "-"), batchSize(batchSize > 0 ? batchSize : 1), maxDelay(
+                maxDelay), socket(-1), stopping(false), writes(0), bytes(0), dropped(
+                0), writeTime(0) {
+    char name[256];
+    if (gethostname(name, sizeof(name)) == 0) {
+        name[sizeof(name) - 1] = '\0';
+        hostname = name;
+    }
+    batch.reserve(this->batchSize);
+    connect();
+    if (maxDelay > milliseconds::zero()) {
+        flusher = std::thread(&SyslogSink::runFlusher, this);
+    }
+}
+
+/**
+ * Destructs a SyslogSink, sending the remaining messages
+ */
+SyslogSink::~SyslogSink() {
+    if (flusher.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeup.notify_one();
+        flusher.join();
+    }
+    flush();
+    if (socket >= 0) {
+        close(socket);
+    }
+}
+
+/**
+ * Connect to the socket (if not connected already)
+ *
+ * @return true if the socket is connected
+ */
+bool SyslogSink::connect() {
+    if (socket >= 0) {
+        return true;
+    }
+
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size());
+
+#ifdef SOCK_CLOEXEC
+    socket = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+#else
+    socket = ::socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (socket >= 0) {
+        fcntl(socket, F_SETFD, FD_CLOEXEC);
+    }
+#endif
+    if (socket < 0) {
+        return false;
+    }
+#ifdef SO_NOSIGPIPE
+    int noSigPipe = 1; // no MSG_NOSIGNAL (e.g. macOS)
+    setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+    if (::connect(socket, reinterpret_cast<sockaddr*>(&address),
+            sizeof(address)) != 0) {
+        close(socket);
+        socket = -1;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Format a message and add it to the batch.
+ * Sends the batch if it is full or the message is a WARNING or ERROR.
+ *
+ * @param message the formatted message
+ * @param logLevel the LogLevel of the message
+ * @param module the module of the message
+ */
+void SyslogSink::write(const std::string& message, const LogLevel& logLevel,
+        const std::string& module) {
+    std::string datagram =
+            format == Format::JOURNALD ?
+                    formatJournald(message, logLevel, module) :
+                    formatRFC5424(message, logLevel, module);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    batch.push_back(std::move(datagram));
+
+    if (batch.size() >= batchSize
+            || static_cast<int>(logLevel)
+                    <= static_cast<int>(LogLevel::WARNING)) {
+        sendBatch();
+    } else if (batch.size() == 1 && flusher.joinable()) {
+        // the flusher has to send this batch after maxDelay at the latest
+        oldest = steady_clock::now();
+        lock.unlock();
+        wakeup.notify_one();
+    }
+}
+
+/**
+ * Send all messages in the batch (without blocking).
+ */
+void SyslogSink::flush() {
+    std::lock_guard<std::mutex> lock(mutex);
+    sendBatch();
+}
+
+/**
+ * Sends a batch once its oldest message has waited for maxDelay, so messages
+ * don't wait indefinitely when only few are logged.
+ */
+void SyslogSink::runFlusher() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        if (batch.empty()) {
+            wakeup.wait(lock);
+        } else if (steady_clock::now() - oldest >= maxDelay) {
+            sendBatch();
+        } else {
+            wakeup.wait_until(lock, oldest + maxDelay);
+        }
+    }
+}
+
+/**
+ * Send all messages in the batch (without blocking), the mutex must be held.
+ * Messages that can't be sent are dropped. A message that is too large for
+ * a single datagram is dropped on its own, the rest of the batch is still
+ * sent.
+ */
+void SyslogSink::sendBatch() {
+    if (batch.empty()) {
+        return;
+    }
+    auto start = steady_clock::now();
+
+    std::size_t sent = 0; // messages handled (sent or skipped)
+    std::size_t delivered = 0; // messages actually sent
+    if (connect()) {
+#ifdef __linux__
+        std::vector<mmsghdr> messages(batch.size());
+        std::vector<iovec> iovecs(batch.size());
+        for (std::size_t i = 0; i < batch.size(); i++) {
+            iovecs[i].iov_base = const_cast<char*>(batch[i].data());
+            iovecs[i].iov_len = batch[i].size();
+            std::memset(&messages[i], 0, sizeof(mmsghdr));
+            messages[i].msg_hdr.msg_iov = &iovecs[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        while (sent < batch.size()) {
+            int result = sendmmsg(socket, &messages[sent],
+                    batch.size() - sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (result > 0) {
+                for (int i = 0; i < result; i++) {
+                    bytes += messages[sent + i].msg_len;
+                }
+                sent += result;
+                delivered += result;
+                continue;
+            }
+            if (result < 0 && errno == EMSGSIZE) {
+                sent++; // the first remaining message is too large, skip it
+                continue;
+            }
+            if (result < 0 && errno != EAGAIN && errno != EWOULDBLOCK
+                    && errno != ENOBUFS) {
+                // receiver is gone, reconnect on next flush
+                close(socket);
+                socket = -1;
+            }
+            break;
+        }
+#else
+        for (; sent < batch.size(); sent++) {
+            ssize_t result = send(socket, batch[sent].data(),
+                    batch[sent].size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (result >= 0) {
+                bytes += result;
+                delivered++;
+                continue;
+            }
+            if (errno == EMSGSIZE) {
+                continue; // too large, skip it
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS) {
+                // receiver is gone, reconnect on next flush
+                close(socket);
+                socket = -1;
+            }
+            break;
+        }
+#endif
+    }
+
+    writes += delivered;
+    dropped += batch.size() - delivered;
+    batch.clear();
+    writeTime += duration_cast<nanoseconds>(steady_clock::now() - start).count();
+}
+
+/**
+ * @return the name of the sink (syslog:<path> or journald:<path>)
+ */
+std::string SyslogSink::getName() const {
+    return (format == Format::JOURNALD ? "journald:" : "syslog:") + path;
+}
+
+/**
+ * Get the statistics of this sink.
+ *
+ * @return a snapshot of the sink's counters
+ */
+SinkStatistics SyslogSink::stats() const {
+    SinkStatistics stats;
+    stats.writes = writes;
+    stats.bytes = bytes;
+    stats.dropped = dropped;
+    stats.writeTime = nanoseconds(writeTime);
+    return stats;
+}
+
+/**
+ * Format a message according to RFC 5424:
+ * <PRI>1 TIMESTAMP HOSTNAME APP-NAME PROCID MSGID - MSG
+ * The module is used as MSGID.
+ *
+ * @param message the formatted message
+ * @param logLevel the LogLevel of the message
+ * @param module the module of the message
+ * @return the datagram
+ */
+std::string SyslogSink::formatRFC5424(const std::string& message,
+        const LogLevel& logLevel, const std::string& module) const {
+    auto now = system_clock::now();
+    std::time_t seconds = system_clock::to_time_t(now);
+    int ms = duration_cast<milliseconds>(now.time_since_epoch()).count()
+            % 1000;
+    std::tm utc;
+    gmtime_r(&seconds, &utc);
+
+    char timestamp[32];
+    std::size_t length = std::strftime(timestamp, sizeof(timestamp),
+            "%Y-%m-%dT%H:%M:%S", &utc);
+    std::snprintf(timestamp + length, sizeof(timestamp) - length, ".%03dZ",
+            ms);
+
+    std::string datagram = "<"
+            + std::to_string(FACILITY_USER * 8 + getSeverity(logLevel)) + ">1 "
+            + timestamp + " " + hostname + " " + appName + " "
+            + std::to_string(getpid()) + " " + getMsgId(module) + " - ";
+    datagram.append(message, 0, getTrimmedLength(message));
+    return datagram;
+}
+
+/**
+ * Format a message using the native journald protocol (KEY=value lines).
+ * A MESSAGE containing newlines is length-prefixed as the protocol requires.
+ *
+ * @param message the formatted message
+ * @param logLevel the LogLevel of the message
+ * @param module the module of the message
+ * @return the datagram
+ */
+std::string SyslogSink::formatJournald(const std::string& message,
+        const LogLevel& logLevel, const std::string& module) const {
+    std::string datagram = "PRIORITY=" + std::to_string(getSeverity(logLevel))
+            + "\nSYSLOG_IDENTIFIER=" + appName + "\nLOG_MODULE=" + module
+            + "\n";
+
+    std::size_t length = getTrimmedLength(message);
+    if (std::memchr(message.data(), '\n', length) == nullptr) {
+        datagram += "MESSAGE=";
+        datagram.append(message, 0, length);
+    } else {
+        datagram += "MESSAGE\n";
+        for (int i = 0; i < 8; i++) { // little endian 64 bit length
+            datagram += static_cast<char>((static_cast<std::uint64_t>(length)
+                    >> (8 * i)) & 0xFF);
+        }
+        datagram.append(message, 0, length);
+    }
+    datagram += "\n";
+    return datagram;
+}
+
+} /* namespace logging */
+/** @} */
@@ -0,0 +1,73 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * Minimal checks shared by the tests.
+ *
+ * Every test is a program of its own: it reports failed checks with CHECK()
+ * and returns getTestResult() from main.
+ */
+
+#ifndef TESTS_CHECK_H_
+#define TESTS_CHECK_H_
+
+#include <cstdio>
+#include <string>
+
+/**
+ * Number of failed checks that are reported in detail
+ */
+static constexpr int MAX_REPORTED_FAILURES = 20;
+
+/**
+ * @return the number of failed checks so far
+ */
+inline int& getFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+/**
+ * Report a failed check
+ *
+ * @param what description of the failure
+ * @param file source file of the check
+ * @param line line of the check
+ */
+inline void reportFailure(const std::string& what, const char* file,
+        int line) {
+    if (getFailures()++ < MAX_REPORTED_FAILURES) {
+        std::fprintf(stderr, "FAILED: %s (%s:%d)\n", what.c_str(), file, line);
+    }
+}
+
+/**
+ * Print the result of the test
+ *
+ * @return the exit code of the test (0 if all checks passed)
+ */
+inline int getTestResult() {
+    if (getFailures() > 0) {
+        std::printf("%d checks FAILED\n", getFailures());
+        return 1;
+    }
+    std::printf("All checks passed\n");
+    return 0;
+}
+
+/**
+ * Check a condition, report WHAT if it doesn't hold
+ */
+#define CHECK(CONDITION, WHAT) \
+    do { \
+        if (!(CONDITION)) { \
+            reportFailure(std::string(WHAT), __FILE__, __LINE__); \
+        } \
+    } while (0)
+
+#endif /* TESTS_CHECK_H_ */
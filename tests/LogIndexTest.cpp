@@ -0,0 +1,304 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * Test for the index of logfiles and for queries using it.
+ *
+ * A Logger writes an indexed logfile with single and multi-line messages in
+ * two modules. Queries using the index (complete, partial, rebuilt and
+ * without one, split into small blocks, with several threads) must return
+ * exactly what a full scan of the logfile returns. Also checks the blocks
+ * of the index, mayContain() and that an index left over from an earlier
+ * logfile is not used.
+ *
+ * Build and run with `make test` (or `make test-asan` / `make test-tsan`).
+ */
+
+#include "Check.h"
+#include "logging/logging.h"
+#include "logging/LogIndex.h"
+#include "logging/LogQuery.h"
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * Number of messages per module, enough for several blocks of the index
+ */
+static constexpr int NUM_MESSAGES = 2000;
+
+/**
+ * Number of lines of the multi-line ERRORs
+ */
+static constexpr int NUM_LINES = 6;
+
+/**
+ * The logfile written by the test
+ */
+static const std::string LOGFILE = "index-test.log";
+
+/**
+ * The index of the logfile
+ */
+static const std::string INDEXFILE = LOGFILE + LOGINDEX_EXTENSION;
+
+#undef LOG_MODULE
+#define LOG_MODULE "alpha"
+/**
+ * Log multi-line ERRORs and single line INFOs
+ */
+static void logAlpha(Logger& logger) {
+    for (int i = 0; i < NUM_MESSAGES; i++) {
+        LOG_ERROR_TO(logger) << "alpha error " << i << "\nline 2\nline 3"
+                << "\nline 4\nline 5\nline 6" << std::endl;
+        LOG_INFO_TO(logger) << "alpha info " << i << std::endl;
+    }
+}
+
+#undef LOG_MODULE
+#define LOG_MODULE "beta"
+/**
+ * Log single line WARNINGs and multi-line DEBUG messages
+ */
+static void logBeta(Logger& logger) {
+    for (int i = 0; i < NUM_MESSAGES; i++) {
+        LOG_WARNING_TO(logger) << "beta warning " << i << std::endl;
+        LOG_DEBUG_TO(logger) << "beta debug " << i << "\nsecond line\n"
+                << "third line" << std::endl;
+    }
+}
+
+#undef LOG_MODULE
+#define LOG_MODULE GLOBAL_MODULE
+
+/**
+ * Read a whole file
+ */
+static std::string readFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file),
+            std::istreambuf_iterator<char>());
+}
+
+/**
+ * Write a file
+ */
+static void writeFile(const std::string& filename, const std::string& content) {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    file << content;
+}
+
+/**
+ * Count the lines of a string
+ */
+static std::size_t countLines(const std::string& text) {
+    std::size_t lines = 0;
+    for (char c : text) {
+        lines += c == '\n';
+    }
+    return lines;
+}
+
+/**
+ * Build a query
+ */
+static LogQuery makeQuery(std::uint32_t logLevels, const std::string& module) {
+    LogQuery query;
+    query.logLevels = logLevels;
+    query.module = module;
+    return query;
+}
+
+/**
+ * The queries every index is checked with
+ */
+static const std::vector<LogQuery>& getQueries() {
+    static const std::vector<LogQuery> queries = {
+            makeQuery((1u << NUM_LOGLEVELS) - 1, ""),
+            makeQuery(1u << static_cast<int>(LogLevel::ERROR), ""),
+            makeQuery(1u << static_cast<int>(LogLevel::DEBUG), "beta"),
+            makeQuery((1u << NUM_LOGLEVELS) - 1, "alpha"),
+            makeQuery(1u << static_cast<int>(LogLevel::TRACE), "") };
+    return queries;
+}
+
+/**
+ * Check that queries using an index return the same as a full scan
+ *
+ * @param log the content of the logfile
+ * @param blocks the index
+ * @param name the name of the index, for reporting
+ */
+static void checkQueries(const std::string& log,
+        const std::vector<LogIndexBlock>& blocks, const std::string& name) {
+    const char* data = log.data();
+    for (const LogQuery& query : getQueries()) {
+        std::string expected = scanLogBlock(data, data + log.size(), query);
+        std::string description = name + ", LogLevels "
+                + std::to_string(query.logLevels) + ", module '" + query.module
+                + "'";
+
+        for (unsigned threads : { 1u, 4u }) {
+            std::string result = queryLog(data, log.size(), blocks, query,
+                    threads);
+            CHECK(result == expected,
+                    description + ": " + std::to_string(countLines(result))
+                            + " lines instead of "
+                            + std::to_string(countLines(expected)));
+        }
+        // split the part not indexed into many small blocks
+        std::string result = queryLog(data, log.size(), blocks, query, 4, 1000);
+        CHECK(result == expected,
+                description + ", small blocks: "
+                        + std::to_string(countLines(result))
+                        + " lines instead of "
+                        + std::to_string(countLines(expected)));
+    }
+}
+
+/**
+ * Check that blocks are contiguous, end at the end of the logfile and start
+ * at the start of a message
+ */
+static void checkBlocks(const std::string& log,
+        const std::vector<LogIndexBlock>& blocks, std::uint64_t firstOffset,
+        const std::string& name) {
+    CHECK(blocks.size() > 2, name + ": only " + std::to_string(blocks.size())
+            + " blocks");
+    std::uint64_t offset = firstOffset;
+    for (std::size_t i = 0; i < blocks.size(); i++) {
+        const LogIndexBlock& block = blocks[i];
+        CHECK(block.offset == offset,
+                name + ": block " + std::to_string(i) + " is not contiguous");
+        CHECK(i + 1 == blocks.size() || block.length >= LOGINDEX_BLOCK_SIZE,
+                name + ": block " + std::to_string(i) + " is too short");
+        LogLine line;
+        const char* begin = log.data() + block.offset;
+        CHECK(block.offset == 0
+                        || parseLogLine(begin, log.data() + log.size(), line),
+                name + ": block " + std::to_string(i)
+                        + " does not start with a message");
+        offset = block.offset + block.length;
+    }
+    CHECK(offset == log.size(), name + ": index does not cover the logfile");
+}
+
+/**
+ * mayContain() of a single block
+ */
+static void testMayContain() {
+    LogIndexBlock block;
+    block.logLevels = 1u << static_cast<int>(LogLevel::WARNING);
+    block.modules = getModuleBit("beta", 4);
+    block.minTime = 1000;
+    block.maxTime = 2000;
+    std::uint32_t warning = 1u << static_cast<int>(LogLevel::WARNING);
+    std::uint32_t error = 1u << static_cast<int>(LogLevel::ERROR);
+    std::uint64_t beta = getModuleBit("beta", 4);
+
+    CHECK(block.mayContain(warning | error, beta, 0, 5000),
+            "mayContain: matching block rejected");
+    CHECK(block.mayContain(warning, beta, 2000, 3000),
+            "mayContain: overlapping time range rejected");
+    CHECK(!block.mayContain(error, beta, 0, 5000),
+            "mayContain: block without the LogLevel accepted");
+    CHECK(!block.mayContain(warning, beta, 2001, 3000),
+            "mayContain: block after the time range accepted");
+    CHECK(!block.mayContain(warning, beta, 0, 999),
+            "mayContain: block before the time range accepted");
+    if (getModuleBit("alpha", 5) != beta) {
+        CHECK(!block.mayContain(warning, getModuleBit("alpha", 5), 0, 5000),
+                "mayContain: block without the module accepted");
+    }
+}
+
+/**
+ * An index left over from an earlier logfile is not used
+ *
+ * @param staleIndex the index of the earlier logfile
+ */
+static void testStaleIndex(const std::string& staleIndex) {
+    Logger logger;
+    logger.setDefaultCoutLogLevel(LogLevel::OFF);
+    logger.setDefaultFileLogLevel(LogLevel::TRACE);
+    logger.setLogfile(LOGFILE); // without index
+    CHECK(!std::ifstream(INDEXFILE), "index of the earlier logfile not removed");
+
+    logBeta(logger);
+    logAlpha(logger);
+    logBeta(logger); // longer than the earlier logfile
+    logger.flush();
+    std::string log = readFile(LOGFILE);
+
+    writeFile(INDEXFILE, staleIndex);
+    std::vector<LogIndexBlock> blocks;
+    CHECK(!readLogIndex(INDEXFILE, log.data(), log.size(), blocks),
+            "index of the earlier logfile accepted");
+}
+
+int main() {
+    testMayContain();
+
+    // write an indexed logfile
+    std::string log;
+    {
+        Logger logger;
+        logger.setDefaultCoutLogLevel(LogLevel::OFF);
+        logger.setDefaultFileLogLevel(LogLevel::TRACE);
+        logger.setLogfile(LOGFILE, true);
+        logAlpha(logger);
+        logBeta(logger);
+    } // closes the logfile and completes the index
+    log = readFile(LOGFILE);
+    std::string header = log.substr(0, log.find('\n') + 1);
+
+    // the index written by the Logger
+    std::vector<LogIndexBlock> blocks;
+    CHECK(readLogIndex(INDEXFILE, log.data(), log.size(), blocks),
+            "index written by the Logger rejected");
+    checkBlocks(log, blocks, header.size(), "Logger index");
+    checkQueries(log, blocks, "Logger index");
+
+    std::string expected = scanLogBlock(log.data(), log.data() + log.size(),
+            getQueries()[1]);
+    CHECK(countLines(expected) == static_cast<std::size_t>(NUM_MESSAGES) * NUM_LINES,
+            "full scan: " + std::to_string(countLines(expected))
+                    + " ERROR lines");
+
+    // the index built afterwards (like `logquery index`)
+    std::vector<LogIndexBlock> rebuilt = buildLogIndex(log.data(), log.size());
+    checkBlocks(log, rebuilt, 0, "rebuilt index");
+    std::ostringstream index;
+    writeLogIndexHeader(index, LOGINDEX_BLOCK_SIZE);
+    for (const LogIndexBlock& block : rebuilt) {
+        writeLogIndexBlock(index, block);
+    }
+    std::string indexContent = index.str();
+    writeFile(INDEXFILE, indexContent);
+    CHECK(readLogIndex(INDEXFILE, log.data(), log.size(), blocks),
+            "rebuilt index rejected");
+    CHECK(blocks.size() == rebuilt.size(), "rebuilt index read incompletely");
+    checkQueries(log, blocks, "rebuilt index");
+
+    // an index that doesn't cover the end of the logfile (yet)
+    blocks.resize(blocks.size() / 2);
+    checkQueries(log, blocks, "partial index");
+
+    // no index
+    checkQueries(log, std::vector<LogIndexBlock>(), "no index");
+
+    testStaleIndex(indexContent);
+
+    std::remove(LOGFILE.c_str());
+    std::remove(INDEXFILE.c_str());
+    return getTestResult();
+}
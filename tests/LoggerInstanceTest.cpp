@@ -0,0 +1,152 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * Test for Logger instances allocated on the heap.
+ *
+ * Loggers created with new and std::make_shared (which only guarantee the
+ * default alignment in C++11) log from several threads to their own
+ * logfile and a custom sink. Afterwards the logfiles and the statistics are
+ * checked.
+ *
+ * Build and run with `make test` (or `make test-asan` / `make test-tsan`).
+ */
+
+#include "Check.h"
+#include "logging/logging.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Number of threads logging to every Logger
+ */
+static constexpr int NUM_THREADS = 4;
+
+/**
+ * Number of messages per thread
+ */
+static constexpr int NUM_MESSAGES = 200;
+
+// new and std::make_shared don't honor a larger alignment in C++11
+static_assert(alignof(Logger) <= alignof(std::max_align_t),
+        "Logger must not require more than the default alignment");
+
+/**
+ * Time a SlowSink spends in write()
+ */
+static const std::chrono::microseconds SLOW_WRITE(100);
+
+/**
+ * A sink that only counts its bytes and takes a while per message.
+ * It does not override stats(), the Logger has to measure it.
+ */
+class SlowSink : public LogSink {
+public:
+    std::uint64_t bytes = 0; ///< bytes written (guarded by the Logger)
+
+    SlowSink() :
+            LogSink(LogLevel::INFO) {
+    }
+
+    virtual void write(const std::string& message, const LogLevel&,
+            const std::string&) override {
+        bytes += message.size();
+        std::this_thread::sleep_for(SLOW_WRITE);
+    }
+
+    virtual std::string getName() const override {
+        return "slow";
+    }
+};
+
+/**
+ * Log from several threads to a Logger and check its logfile and statistics
+ *
+ * @param logger the Logger to test
+ * @param name the name of the Logger (and its logfile)
+ */
+static void testLogger(Logger& logger, const std::string& name) {
+    CHECK(reinterpret_cast<std::uintptr_t>(&logger) % alignof(Logger) == 0,
+            name + ": Logger is misaligned");
+
+    std::string logfile = name + ".log";
+    logger.setDefaultCoutLogLevel(LogLevel::OFF);
+    logger.setDefaultFileLogLevel(LogLevel::INFO);
+    logger.setLogfile(logfile);
+    auto sink = std::make_shared<SlowSink>();
+    logger.addSink(sink);
+
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < NUM_THREADS; thread++) {
+        threads.emplace_back([&logger, thread]() {
+            for (int i = 0; i < NUM_MESSAGES; i++) {
+                LOG_INFO_TO(logger) << "thread " << thread << " message " << i
+                        << std::endl;
+                LOG_DEBUG_TO(logger) << "filtered" << std::endl;
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    logger.flush();
+
+    LogStatistics stats = logger.stats();
+    std::uint64_t expected = static_cast<std::uint64_t>(NUM_THREADS)
+            * NUM_MESSAGES;
+    CHECK(stats.records[static_cast<int>(LogLevel::INFO)] == expected,
+            name + ": " + std::to_string(stats.records[static_cast<int>(LogLevel::INFO)])
+                    + " INFO messages counted");
+    CHECK(stats.filtered == expected,
+            name + ": " + std::to_string(stats.filtered) + " messages filtered");
+
+    SinkStatistics sinkStats = stats.sinks["slow"];
+    CHECK(sinkStats.writes == expected,
+            name + ": " + std::to_string(sinkStats.writes)
+                    + " writes to the sink counted");
+    CHECK(sinkStats.bytes == sink->bytes,
+            name + ": " + std::to_string(sinkStats.bytes) + " bytes counted, "
+                    + std::to_string(sink->bytes) + " written to the sink");
+    CHECK(sinkStats.writeTime >= expected * SLOW_WRITE,
+            name + ": only "
+                    + std::to_string(sinkStats.writeTime.count())
+                    + "ns spent writing to the sink");
+
+    std::ifstream file(logfile);
+    std::string line;
+    std::getline(file, line); // header
+    std::uint64_t lines = 0;
+    while (std::getline(file, line)) {
+        CHECK(line.find("message") != std::string::npos,
+                name + ": unexpected line: " + line);
+        lines++;
+    }
+    CHECK(lines == expected,
+            name + ": " + std::to_string(lines) + " lines in the logfile");
+}
+
+int main() {
+    Logger* logger = new Logger();
+    testLogger(*logger, "instance-test-new");
+    delete logger;
+    std::remove("instance-test-new.log");
+
+    std::shared_ptr<Logger> sharedLogger = std::make_shared<Logger>();
+    testLogger(*sharedLogger, "instance-test-shared");
+    sharedLogger.reset();
+    std::remove("instance-test-shared.log");
+
+    return getTestResult();
+}
@@ -0,0 +1,423 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/** 
+ * @file
+ * Multithreaded stress test for the Logger.
+ *
+ * Many threads log messages of all LogLevels in different modules using the
+ * LOG_XXX macros, to the logfile and to a SyslogSink (received by a local
+ * socket). Afterwards the logfile and the datagrams are checked:
+ * - every message is intact (no interleaving, no truncation at BUFFER_SIZE)
+ * - the messages of every thread are in order
+ * - filtered messages never appear, no message is missing
+ * - LOG_LAZY arguments are only evaluated for messages that are printed
+ *
+ * Build and run with `make test` (or `make test-asan` / `make test-tsan`).
+ */
+
+#include "Check.h"
+#include "logging/logging.h"
+#include "logging/LogIndex.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * Number of threads logging concurrently
+ */
+static constexpr int NUM_THREADS = 8;
+
+/**
+ * Number of rounds per thread (every round logs all LogLevels)
+ */
+static constexpr int NUM_ROUNDS = 500;
+
+/**
+ * Longest payload, long enough to cross BUFFER_SIZE several times
+ */
+static constexpr int MAX_PAYLOAD = 3 * BUFFER_SIZE;
+
+/**
+ * The logfile written by the test
+ */
+static const char* const LOGFILE = "stress-test.log";
+
+/**
+ * The modules the threads log to and their LogLevel for the logfile
+ * (delta is blacklisted)
+ */
+static const char* const MODULES[] = { "alpha", "beta", "gamma", "delta" };
+static const LogLevel FILE_LOGLEVELS[] = { LogLevel::TRACE, LogLevel::INFO,
+        LogLevel::ERROR, LogLevel::OFF };
+static constexpr int NUM_MODULES = 4;
+
+/**
+ * LogLevel of the SyslogSink (module LogLevels do not apply to it)
+ */
+static const LogLevel SINK_LOGLEVEL = LogLevel::DEBUG;
+
+/**
+ * Percentage of the sink's messages that must at least arrive. The socket
+ * only queues a few datagrams, so the sink may drop some while the threads
+ * log; delivery without drops is checked by SyslogSinkTest.cpp.
+ */
+static constexpr std::uint64_t MIN_DELIVERED_PERCENT = 10;
+
+/**
+ * Length of the payload of a message
+ */
+static int getPayloadLength(int thread, int sequence) {
+    return (thread * 131 + sequence * 37) % (MAX_PAYLOAD + 1);
+}
+
+/**
+ * The expected payload of a message
+ */
+static std::string getPayload(int thread, int sequence) {
+    int length = getPayloadLength(thread, sequence);
+    std::string payload(length, ' ');
+    for (int i = 0; i < length; i++) {
+        payload[i] = 'a' + (thread + sequence + i) % 26;
+    }
+    return payload;
+}
+
+/**
+ * Number of times the LOG_LAZY payload was computed (DEBUG messages only)
+ */
+static std::atomic<int> lazyCalls { 0 };
+
+// Every message: T<thread> S<sequence> <payload>|
+#define LOG_MESSAGE(LOG_XXX, THREAD, SEQUENCE) \
+    LOG_XXX << "T" << THREAD << " S" << SEQUENCE << " " << getPayload(THREAD, SEQUENCE) << "|" << std::endl;
+
+// Every round logs all LogLevels, so sequence % NUM_LOGLEVELS is the LogLevel
+#define LOG_ROUND(THREAD, SEQUENCE) \
+    LOG_MESSAGE(LOG_ERROR, THREAD, SEQUENCE) \
+    SEQUENCE++; \
+    LOG_MESSAGE(LOG_WARNING, THREAD, SEQUENCE) \
+    SEQUENCE++; \
+    LOG_MESSAGE(LOG_INFO, THREAD, SEQUENCE) \
+    SEQUENCE++; \
+    LOG_DEBUG << "T" << THREAD << " S" << SEQUENCE << " " << LOG_LAZY([&]{ lazyCalls++; return getPayload(THREAD, SEQUENCE); }) << "|" << std::endl; \
+    SEQUENCE++; \
+    LOG_MESSAGE(LOG_TRACE, THREAD, SEQUENCE) \
+    SEQUENCE++;
+
+// one worker per module, LOG_MODULE is fixed per call site
+#undef LOG_MODULE
+#define LOG_MODULE "alpha"
+static void logAlpha(int thread) {
+    LOG_SCOPE
+    int sequence = 0;
+    for (int round = 0; round < NUM_ROUNDS; round++) {
+        LOG_ROUND(thread, sequence)
+    }
+}
+
+#undef LOG_MODULE
+#define LOG_MODULE "beta"
+static void logBeta(int thread) {
+    LOG_SCOPE
+    int sequence = 0;
+    for (int round = 0; round < NUM_ROUNDS; round++) {
+        LOG_ROUND(thread, sequence)
+    }
+}
+
+#undef LOG_MODULE
+#define LOG_MODULE "gamma"
+static void logGamma(int thread) {
+    LOG_SCOPE
+    int sequence = 0;
+    for (int round = 0; round < NUM_ROUNDS; round++) {
+        LOG_ROUND(thread, sequence)
+    }
+}
+
+#undef LOG_MODULE
+#define LOG_MODULE "delta"
+static void logDelta(int thread) {
+    LOG_SCOPE
+    int sequence = 0;
+    for (int round = 0; round < NUM_ROUNDS; round++) {
+        LOG_ROUND(thread, sequence)
+    }
+}
+
+#undef LOG_MODULE
+#define LOG_MODULE GLOBAL_MODULE
+
+/**
+ * Check whether a LogLevel passes a threshold
+ */
+static bool passes(LogLevel logLevel, LogLevel threshold) {
+    return threshold != LogLevel::OFF
+            && static_cast<int>(logLevel) <= static_cast<int>(threshold);
+}
+
+/**
+ * Checks the messages of one sink (the logfile or the datagrams).
+ */
+class MessageChecker {
+private:
+    std::string sink; ///< name of the sink, for reporting
+    bool useModuleLogLevels; ///< do the module LogLevels apply to the sink
+    LogLevel sinkLogLevel; ///< the LogLevel of the sink otherwise
+    int lastSequence[NUM_THREADS]; ///< last sequence per thread
+    int count[NUM_THREADS]; ///< number of messages per thread
+public:
+    MessageChecker(const std::string& sink, bool useModuleLogLevels,
+            LogLevel sinkLogLevel) :
+            sink(sink), useModuleLogLevels(useModuleLogLevels), sinkLogLevel(
+                    sinkLogLevel) {
+        for (int i = 0; i < NUM_THREADS; i++) {
+            lastSequence[i] = -1;
+            count[i] = 0;
+        }
+    }
+
+    /**
+     * Is a message expected in this sink?
+     */
+    bool isExpected(int module, LogLevel logLevel) const {
+        if (module == 3) { // blacklisted
+            return false;
+        }
+        return passes(logLevel,
+                useModuleLogLevels ? FILE_LOGLEVELS[module] : sinkLogLevel);
+    }
+
+    /**
+     * Number of messages expected per thread
+     */
+    int getExpectedCount(int thread) const {
+        int expected = 0;
+        for (int level = 0; level < NUM_LOGLEVELS; level++) {
+            expected += isExpected(thread % NUM_MODULES,
+                    static_cast<LogLevel>(level)) ? NUM_ROUNDS : 0;
+        }
+        return expected;
+    }
+
+    /**
+     * Check a single message (a line without the trailing newline)
+     */
+    void check(const std::string& message) {
+        LogLine line;
+        bool parsed = parseLogLine(message.data(),
+                message.data() + message.size(), line);
+        CHECK(parsed, sink + ": can't parse: " + message.substr(0, 80));
+        if (!parsed) {
+            return;
+        }
+        std::string module(line.module, line.moduleLength);
+        if (message.find("]: Entering Scope") != std::string::npos
+                || message.find("]: Leaving Scope") != std::string::npos) {
+            return; // LOG_SCOPE
+        }
+
+        int thread;
+        int sequence;
+        int offset;
+        std::size_t start = message.find("]: T");
+        bool valid = start != std::string::npos
+                && std::sscanf(message.c_str() + start + 3, "T%d S%d %n",
+                        &thread, &sequence, &offset) == 2 && thread >= 0
+                && thread < NUM_THREADS;
+        CHECK(valid, sink + ": garbled message: " + message.substr(0, 80));
+        if (!valid) {
+            return;
+        }
+
+        int moduleIndex = thread % NUM_MODULES;
+        CHECK(module == MODULES[moduleIndex],
+                sink + ": wrong module: " + message.substr(0, 80));
+        CHECK(static_cast<int>(line.logLevel) == sequence % NUM_LOGLEVELS,
+                sink + ": wrong LogLevel: " + message.substr(0, 80));
+        CHECK(isExpected(moduleIndex, line.logLevel),
+                sink + ": filtered message printed: " + message.substr(0, 80));
+
+        std::string payload = message.substr(start + 3 + offset);
+        CHECK(payload == getPayload(thread, sequence) + "|",
+                sink + ": payload broken: " + message.substr(0, 80));
+        CHECK(sequence > lastSequence[thread],
+                sink + ": out of order: " + message.substr(0, 80));
+        lastSequence[thread] = sequence;
+        count[thread]++;
+    }
+
+    /**
+     * Check that all expected messages were seen
+     *
+     * @param missing number of messages that may be missing (dropped)
+     */
+    void checkComplete(int missing) {
+        int total = 0;
+        int expected = 0;
+        for (int thread = 0; thread < NUM_THREADS; thread++) {
+            total += count[thread];
+            expected += getExpectedCount(thread);
+            if (missing == 0) {
+                CHECK(count[thread] == getExpectedCount(thread),
+                        sink + ": wrong number of messages of thread "
+                                + std::to_string(thread) + ": "
+                                + std::to_string(count[thread]) + " instead of "
+                                + std::to_string(getExpectedCount(thread)));
+            }
+        }
+        CHECK(total + missing == expected,
+                sink + ": " + std::to_string(total) + " messages + "
+                        + std::to_string(missing) + " dropped instead of "
+                        + std::to_string(expected));
+        std::printf("%s: %d messages checked\n", sink.c_str(), total);
+    }
+};
+
+int main() {
+    // local stand-in for syslog
+    std::string socketPath = "/tmp/cxx-logging-test-" + std::to_string(getpid())
+            + ".sock";
+    unlink(socketPath.c_str());
+    int listener = socket(AF_UNIX, SOCK_DGRAM, 0);
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socketPath.c_str(),
+            sizeof(address.sun_path) - 1);
+    timeval timeout = { 0, 100000 }; // to check for stop
+    if (listener < 0
+            || bind(listener, reinterpret_cast<sockaddr*>(&address),
+                    sizeof(address)) != 0
+            || setsockopt(listener, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+                    sizeof(timeout)) != 0) {
+        std::perror("Can't create listener socket");
+        return 1;
+    }
+
+    std::vector<std::string> datagrams;
+    std::atomic<bool> stop { false };
+    std::thread receiver([&]() {
+        char buffer[8192];
+        while (true) {
+            ssize_t length = recv(listener, buffer, sizeof(buffer), 0);
+            if (length > 0) {
+                datagrams.emplace_back(buffer, length);
+            } else if (stop) {
+                break;
+            }
+        }
+    });
+
+    // configure the Logger
+    SET_LOGLEVEL_COUT(LogLevel::OFF);
+    SET_LOGLEVEL_FILE(LogLevel::TRACE);
+    for (int module = 0; module < NUM_MODULES; module++) {
+        SET_LOGLEVELS_MODULE(MODULES[module], LogLevel::OFF,
+                FILE_LOGLEVELS[module]);
+    }
+    LOGGING_SET_BLACKLIST("delta");
+    SET_LOGFILE(LOGFILE);
+    auto sink = std::make_shared<SyslogSink>(socketPath, SINK_LOGLEVEL,
+            SyslogSink::Format::RFC5424, "stress-test");
+    ADD_LOG_SINK(sink);
+
+    // log concurrently
+    void (*workers[NUM_MODULES])(int) = { logAlpha, logBeta, logGamma, logDelta };
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < NUM_THREADS; thread++) {
+        threads.emplace_back(workers[thread % NUM_MODULES], thread);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    Logger::getLogger().flush();
+    LogStatistics stats = Logger::getLogger().stats();
+
+    stop = true;
+    receiver.join();
+    close(listener);
+    unlink(socketPath.c_str());
+
+    // check the logfile
+    MessageChecker fileChecker("logfile", true, LogLevel::OFF);
+    std::ifstream file(LOGFILE);
+    std::string line;
+    std::getline(file, line); // header
+    while (std::getline(file, line)) {
+        fileChecker.check(line);
+    }
+    fileChecker.checkComplete(0);
+
+    // check the datagrams
+    MessageChecker sinkChecker("syslog", false, SINK_LOGLEVEL);
+    for (const std::string& datagram : datagrams) {
+        std::size_t start = datagram.find('[');
+        CHECK(start != std::string::npos,
+                "syslog: no message in datagram: " + datagram.substr(0, 80));
+        if (start != std::string::npos) {
+            sinkChecker.check(datagram.substr(start));
+        }
+    }
+    SinkStatistics sinkStats = sink->stats();
+    CHECK(sinkStats.writes == datagrams.size(),
+            "syslog: sent " + std::to_string(sinkStats.writes) + " but received "
+                    + std::to_string(datagrams.size()));
+    std::uint64_t sinkMessages = sinkStats.writes + sinkStats.dropped;
+    CHECK(datagrams.size() * 100 >= sinkMessages * MIN_DELIVERED_PERCENT,
+            "syslog: only " + std::to_string(datagrams.size()) + " of "
+                    + std::to_string(sinkMessages) + " messages received");
+    sinkChecker.checkComplete(sinkStats.dropped);
+    std::printf("syslog: %llu messages dropped (receiver too slow)\n",
+            static_cast<unsigned long long>(sinkStats.dropped));
+
+    // check the statistics
+    std::uint64_t records = 0;
+    for (std::uint64_t count : stats.records) {
+        records += count;
+    }
+    std::uint64_t logged = static_cast<std::uint64_t>(NUM_THREADS) * NUM_ROUNDS
+            * NUM_LOGLEVELS;
+    CHECK(records + stats.filtered >= logged,
+            "statistics: " + std::to_string(records) + " printed + "
+                    + std::to_string(stats.filtered) + " filtered < "
+                    + std::to_string(logged) + " logged");
+
+    // LOG_LAZY is only evaluated for DEBUG messages that are printed
+    int debugPrinted = 0;
+    for (int thread = 0; thread < NUM_THREADS; thread++) {
+        if (thread % NUM_MODULES != 3) { // delta is blacklisted
+            debugPrinted += NUM_ROUNDS;
+        }
+    }
+    CHECK(stats.records[static_cast<int>(LogLevel::DEBUG)]
+                    == static_cast<std::uint64_t>(debugPrinted),
+            "statistics: "
+                    + std::to_string(stats.records[static_cast<int>(LogLevel::DEBUG)])
+                    + " DEBUG messages printed instead of "
+                    + std::to_string(debugPrinted));
+    CHECK(lazyCalls == debugPrinted,
+            "LOG_LAZY: evaluated " + std::to_string(lazyCalls) + " times for "
+                    + std::to_string(debugPrinted) + " printed messages");
+
+    if (getFailures() == 0) {
+        std::remove(LOGFILE); // kept for inspection otherwise
+    }
+    return getTestResult();
+}
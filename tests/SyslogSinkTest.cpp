@@ -0,0 +1,319 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/**
+ * @file
+ * Deterministic test for the SyslogSink.
+ *
+ * A single thread writes small batches to the sink, flushes them and
+ * receives them from a local socket (blocking), so no datagram may be
+ * dropped. Every datagram is checked against the exact RFC 5424 / journald
+ * layout. Also checks that modules are mapped to valid MSGIDs, that
+ * oversized datagrams are dropped on their own and that a batch is sent after
+ * maxDelay.
+ *
+ * Build and run with `make test` (or `make test-asan` / `make test-tsan`).
+ */
+
+#include "Check.h"
+#include "logging/logging.h"
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * Number of batches written per format
+ */
+static constexpr int NUM_BATCHES = 50;
+
+/**
+ * Messages per batch (below the queue length of the socket)
+ */
+static constexpr unsigned BATCH_SIZE = 4;
+
+/**
+ * Size of a datagram that can't be sent (larger than the send buffer)
+ */
+static constexpr std::size_t OVERSIZED = 1 << 20;
+
+/**
+ * Local stand-in for syslog / journald
+ */
+class Receiver {
+    std::string path;
+    int listener;
+public:
+    explicit Receiver(const std::string& path) :
+            path(path), listener(socket(AF_UNIX, SOCK_DGRAM, 0)) {
+        unlink(path.c_str());
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, path.c_str(),
+                sizeof(address.sun_path) - 1);
+        timeval timeout = { 2, 0 }; // don't hang if a datagram is missing
+        if (listener < 0
+                || bind(listener, reinterpret_cast<sockaddr*>(&address),
+                        sizeof(address)) != 0
+                || setsockopt(listener, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+                        sizeof(timeout)) != 0) {
+            std::perror("Can't create listener socket");
+        }
+    }
+
+    ~Receiver() {
+        close(listener);
+        unlink(path.c_str());
+    }
+
+    /**
+     * @return the next datagram, empty if none arrived in time
+     */
+    std::string receive() {
+        static char buffer[1 << 16];
+        ssize_t length = recv(listener, buffer, sizeof(buffer), 0);
+        return length > 0 ? std::string(buffer, length) : std::string();
+    }
+};
+
+/**
+ * @return the HOSTNAME the sink uses
+ */
+static std::string getHostname() {
+    char name[256];
+    if (gethostname(name, sizeof(name)) != 0) {
+        return "-";
+    }
+    name[sizeof(name) - 1] = '\0';
+    return name;
+}
+
+/**
+ * @return the syslog severity of a LogLevel
+ */
+static int getSeverity(LogLevel logLevel) {
+    switch (logLevel) {
+    case LogLevel::ERROR:
+        return 3;
+    case LogLevel::WARNING:
+        return 4;
+    case LogLevel::INFO:
+        return 6;
+    default:
+        return 7;
+    }
+}
+
+/**
+ * Check that a timestamp looks like 2018-02-03T23:02:28.123Z
+ */
+static bool isTimestamp(const std::string& timestamp) {
+    const char* pattern = "dddd-dd-ddTdd:dd:dd.dddZ";
+    if (timestamp.size() != std::strlen(pattern)) {
+        return false;
+    }
+    for (std::size_t i = 0; i < timestamp.size(); i++) {
+        if (pattern[i] == 'd' ?
+                !std::isdigit(static_cast<unsigned char>(timestamp[i])) :
+                timestamp[i] != pattern[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Check a datagram against the RFC 5424 layout:
+ * <PRI>1 TIMESTAMP HOSTNAME APP-NAME PROCID MSGID - MSG
+ */
+static void checkRFC5424(const std::string& datagram, LogLevel logLevel,
+        const std::string& module, const std::string& message) {
+    std::string header = "<" + std::to_string(8 + getSeverity(logLevel)) + ">1 ";
+    std::string timestamp = datagram.substr(header.size(), 24);
+    std::string rest = " " + getHostname() + " sink-test "
+            + std::to_string(getpid()) + " " + (module.empty() ? "-" : module)
+            + " - " + message.substr(0, message.find_last_not_of('\n') + 1);
+
+    CHECK(datagram.compare(0, header.size(), header) == 0,
+            "rfc5424: wrong header: " + datagram);
+    CHECK(isTimestamp(timestamp), "rfc5424: wrong timestamp: " + datagram);
+    CHECK(datagram.size() > header.size() + 24
+                    && datagram.substr(header.size() + 24) == rest,
+            "rfc5424: wrong datagram: " + datagram);
+}
+
+/**
+ * The expected journald datagram
+ */
+static std::string getJournald(LogLevel logLevel, const std::string& module,
+        const std::string& message) {
+    std::string trimmed = message.substr(0,
+            message.find_last_not_of('\n') + 1);
+    std::string datagram = "PRIORITY=" + std::to_string(getSeverity(logLevel))
+            + "\nSYSLOG_IDENTIFIER=sink-test\nLOG_MODULE=" + module + "\n";
+    if (trimmed.find('\n') == std::string::npos) {
+        return datagram + "MESSAGE=" + trimmed + "\n";
+    }
+    datagram += "MESSAGE\n";
+    for (int i = 0; i < 8; i++) {
+        datagram += static_cast<char>((trimmed.size() >> (8 * i)) & 0xFF);
+    }
+    return datagram + trimmed + "\n";
+}
+
+/**
+ * Check that a sink sent all datagrams and dropped the expected ones
+ */
+static void checkStats(const SyslogSink& sink, std::uint64_t writes,
+        std::uint64_t dropped) {
+    SinkStatistics stats = sink.stats();
+    CHECK(stats.writes == writes,
+            sink.getName() + ": " + std::to_string(stats.writes)
+                    + " datagrams sent, expected " + std::to_string(writes));
+    CHECK(stats.dropped == dropped,
+            sink.getName() + ": " + std::to_string(stats.dropped)
+                    + " datagrams dropped, expected " + std::to_string(dropped));
+}
+
+/**
+ * Batches of RFC 5424 datagrams, flushed after every batch
+ */
+static void testRFC5424(const std::string& path) {
+    Receiver receiver(path);
+    SyslogSink sink(path, LogLevel::TRACE, SyslogSink::Format::RFC5424,
+            "sink-test", BATCH_SIZE, std::chrono::milliseconds(0));
+    const LogLevel logLevels[] = { LogLevel::TRACE, LogLevel::DEBUG,
+            LogLevel::INFO, LogLevel::ERROR };
+    const char* const modules[] = { "alpha", "", "beta", "gamma" };
+
+    for (int batch = 0; batch < NUM_BATCHES; batch++) {
+        for (unsigned i = 0; i < BATCH_SIZE; i++) {
+            std::string message = "batch " + std::to_string(batch)
+                    + " message " + std::to_string(i) + "\n";
+            sink.write(message, logLevels[i], modules[i]);
+        }
+        sink.flush();
+        for (unsigned i = 0; i < BATCH_SIZE; i++) {
+            std::string message = "batch " + std::to_string(batch)
+                    + " message " + std::to_string(i);
+            checkRFC5424(receiver.receive(), logLevels[i], modules[i], message);
+        }
+    }
+    checkStats(sink, NUM_BATCHES * BATCH_SIZE, 0);
+}
+
+/**
+ * Batches of journald datagrams (with single and multiple lines)
+ */
+static void testJournald(const std::string& path) {
+    Receiver receiver(path);
+    SyslogSink sink(path, LogLevel::TRACE, SyslogSink::Format::JOURNALD,
+            "sink-test", BATCH_SIZE, std::chrono::milliseconds(0));
+    const LogLevel logLevels[] = { LogLevel::INFO, LogLevel::DEBUG,
+            LogLevel::TRACE, LogLevel::WARNING };
+
+    for (int batch = 0; batch < NUM_BATCHES; batch++) {
+        std::string messages[BATCH_SIZE];
+        for (unsigned i = 0; i < BATCH_SIZE; i++) {
+            messages[i] = "batch " + std::to_string(batch) + " message "
+                    + std::to_string(i) + "\n";
+            if (i % 2 == 1) {
+                messages[i] += "second line\n";
+            }
+            sink.write(messages[i], logLevels[i], "module");
+        }
+        sink.flush();
+        for (unsigned i = 0; i < BATCH_SIZE; i++) {
+            std::string datagram = receiver.receive();
+            CHECK(datagram == getJournald(logLevels[i], "module", messages[i]),
+                    "journald: wrong datagram: " + datagram);
+        }
+    }
+    checkStats(sink, NUM_BATCHES * BATCH_SIZE, 0);
+}
+
+/**
+ * Modules that are no valid MSGID are made valid
+ */
+static void testMsgId(const std::string& path) {
+    Receiver receiver(path);
+    SyslogSink sink(path, LogLevel::TRACE, SyslogSink::Format::RFC5424,
+            "sink-test", BATCH_SIZE, std::chrono::milliseconds(0));
+
+    sink.write("space\n", LogLevel::INFO, "my module");
+    sink.write("non-ASCII\n", LogLevel::INFO, "m\xC3\xB6" "dule");
+    sink.write("long\n", LogLevel::INFO, std::string(40, 'm'));
+    sink.flush();
+    checkRFC5424(receiver.receive(), LogLevel::INFO, "my_module", "space");
+    checkRFC5424(receiver.receive(), LogLevel::INFO, "m__dule", "non-ASCII");
+    checkRFC5424(receiver.receive(), LogLevel::INFO, std::string(32, 'm'),
+            "long");
+    checkStats(sink, 3, 0);
+}
+
+/**
+ * An oversized datagram is dropped, the rest of its batch is still sent
+ */
+static void testOversized(const std::string& path) {
+    Receiver receiver(path);
+    SyslogSink sink(path, LogLevel::TRACE, SyslogSink::Format::RFC5424,
+            "sink-test", BATCH_SIZE, std::chrono::milliseconds(0));
+
+    sink.write("before\n", LogLevel::INFO, "module");
+    sink.write(std::string(OVERSIZED, 'x'), LogLevel::INFO, "module");
+    sink.write("after\n", LogLevel::INFO, "module");
+    sink.flush();
+    checkRFC5424(receiver.receive(), LogLevel::INFO, "module", "before");
+    checkRFC5424(receiver.receive(), LogLevel::INFO, "module", "after");
+
+    // the connection is kept
+    sink.write("next batch\n", LogLevel::INFO, "module");
+    sink.flush();
+    checkRFC5424(receiver.receive(), LogLevel::INFO, "module", "next batch");
+    checkStats(sink, 3, 1);
+}
+
+/**
+ * A batch that is not full is sent after maxDelay
+ */
+static void testMaxDelay(const std::string& path) {
+    Receiver receiver(path);
+    std::chrono::milliseconds maxDelay(50);
+    SyslogSink sink(path, LogLevel::TRACE, SyslogSink::Format::RFC5424,
+            "sink-test", BATCH_SIZE, maxDelay);
+
+    auto start = std::chrono::steady_clock::now();
+    sink.write("delayed\n", LogLevel::INFO, "module");
+    std::string datagram = receiver.receive();
+    auto delay = std::chrono::steady_clock::now() - start;
+
+    CHECK(!datagram.empty(), "maxDelay: batch was not sent");
+    checkRFC5424(datagram, LogLevel::INFO, "module", "delayed");
+    CHECK(delay >= maxDelay, "maxDelay: batch was sent too early");
+    sink.flush(); // waits until the flusher has updated the statistics
+    checkStats(sink, 1, 0);
+}
+
+int main() {
+    std::string path = "/tmp/cxx-logging-sink-test-" + std::to_string(getpid())
+            + ".sock";
+
+    testRFC5424(path);
+    testJournald(path);
+    testMsgId(path);
+    testOversized(path);
+    testMaxDelay(path);
+
+    return getTestResult();
+}
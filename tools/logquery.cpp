@@ -0,0 +1,236 @@
+/*
+ * Copyright © 2017-2018 Steven Beyermann, Markus Blechschmidt, Moritz Höwer,
+ * Lasse Lüder, Andre Radtke
+ *
+ * This software is licensed by MIT License.
+ * See LICENSE for details.
+ */
+/** 
+ * @file
+ * Searches logfiles written by the Logger, using their index.
+ *
+ * Usage:
+ *   logquery index <logfile>
+ *       (re)builds the index of an existing logfile
+ *   logquery [-l <LogLevel>] [-m <module>] [-f <from>] [-t <to>] [-j <threads>] <logfile>
+ *       prints all messages at least as severe as LogLevel, in module, logged
+ *       between from and to (mm:ss.mmm)
+ *
+ * Only the blocks of the logfile that may contain matching messages (according
+ * to the index) are scanned, using multiple threads. Parts of the logfile not
+ * covered by the index (yet) are always scanned.
+ */
+
+#include "logging/LogIndex.h"
+#include "logging/LogQuery.h"
+#include "logging/Logger.h"
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace logging;
+
+/**
+ * A logfile mapped into memory
+ */
+class MappedFile {
+private:
+    const char* data; ///< the content of the file
+    std::size_t length; ///< the length of the file
+public:
+    /**
+     * Maps a file into memory.
+     *
+     * @param filename the file to map
+     */
+    explicit MappedFile(const std::string& filename) :
+            data(nullptr), length(0) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE,
+                    fd, 0);
+            if (mapped != MAP_FAILED) {
+                data = static_cast<const char*>(mapped);
+                length = info.st_size;
+            }
+        }
+        close(fd);
+    }
+
+    /**
+     * Unmaps the file
+     */
+    ~MappedFile() {
+        if (data != nullptr) {
+            munmap(const_cast<char*>(data), length);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @return the content of the file, nullptr if it could not be mapped
+     */
+    const char* getData() const {
+        return data;
+    }
+
+    /**
+     * @return the length of the file
+     */
+    std::size_t getLength() const {
+        return length;
+    }
+};
+
+/**
+ * Print the usage
+ *
+ * @return the exit code
+ */
+static int usage() {
+    std::cerr << "Usage: logquery index <logfile>" << std::endl
+            << "       logquery [-l <LogLevel>] [-m <module>] [-f <mm:ss.mmm>]"
+            << " [-t <mm:ss.mmm>] [-j <threads>] <logfile>" << std::endl;
+    return 2;
+}
+
+/**
+ * Parse a LogLevel given on the command line
+ *
+ * @param name the name of the LogLevel
+ * @param[out] logLevels bitmap of the LogLevel and all more severe LogLevels
+ * @return false if name is no LogLevel
+ */
+static bool parseLogLevel(const std::string& name, std::uint32_t& logLevels) {
+    for (int level = 0; level < NUM_LOGLEVELS; level++) {
+        std::ostringstream os;
+        os << static_cast<LogLevel>(level);
+        if (os.str() == name) {
+            logLevels = (2u << level) - 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Build (or rebuild) the index of an existing logfile
+ *
+ * @param filename the logfile
+ * @return the exit code
+ */
+static int buildIndex(const std::string& filename) {
+    MappedFile log(filename);
+    if (log.getData() == nullptr) {
+        std::cerr << "Can't read " << filename << std::endl;
+        return 1;
+    }
+
+    std::ofstream index(filename + LOGINDEX_EXTENSION,
+            std::ios::trunc | std::ios::binary);
+    writeLogIndexHeader(index, LOGINDEX_BLOCK_SIZE);
+    std::vector<LogIndexBlock> blocks = buildLogIndex(log.getData(),
+            log.getLength());
+    for (const LogIndexBlock& block : blocks) {
+        writeLogIndexBlock(index, block);
+    }
+    if (!index) {
+        std::cerr << "Can't write " << filename << LOGINDEX_EXTENSION
+                << std::endl;
+        return 1;
+    }
+    std::cerr << "Indexed " << blocks.size() << " blocks" << std::endl;
+    return 0;
+}
+
+/**
+ * Run a query on a logfile
+ *
+ * @param filename the logfile
+ * @param query the query
+ * @param threads the maximum number of threads to scan with
+ * @return the exit code
+ */
+static int runQuery(const std::string& filename, const LogQuery& query,
+        unsigned threads) {
+    MappedFile log(filename);
+    if (log.getData() == nullptr) {
+        std::cerr << "Can't read " << filename << std::endl;
+        return 1;
+    }
+
+    std::vector<LogIndexBlock> blocks;
+    if (!readLogIndex(filename + LOGINDEX_EXTENSION, log.getData(),
+            log.getLength(), blocks)) {
+        std::cerr << "No matching index for " << filename
+                << ", scanning the whole logfile" << std::endl;
+        blocks.clear();
+    }
+
+    std::cout << queryLog(log.getData(), log.getLength(), blocks, query,
+            threads) << std::flush;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc == 3 && std::strcmp(argv[1], "index") == 0) {
+        return buildIndex(argv[2]);
+    }
+
+    LogQuery query;
+    query.logLevels = (1u << NUM_LOGLEVELS) - 1;
+    unsigned threads = std::thread::hardware_concurrency();
+    int i = 1;
+    for (; i + 1 < argc && argv[i][0] == '-'; i += 2) {
+        std::string option = argv[i];
+        std::string value = argv[i + 1];
+        if (option == "-l") {
+            if (!parseLogLevel(value, query.logLevels)) {
+                std::cerr << "Unknown LogLevel " << value << std::endl;
+                return usage();
+            }
+        } else if (option == "-m") {
+            query.module = value;
+        } else if (option == "-f") {
+            if (!parseTime(value, query.from)) {
+                return usage();
+            }
+        } else if (option == "-t") {
+            if (!parseTime(value, query.to)) {
+                return usage();
+            }
+        } else if (option == "-j") {
+            char* end;
+            long number = std::strtol(value.c_str(), &end, 10);
+            if (*end != '\0' || number <= 0
+                    || number > std::numeric_limits<int>::max()) {
+                std::cerr << "Invalid number of threads " << value << std::endl;
+                return usage();
+            }
+            threads = number;
+        } else {
+            return usage();
+        }
+    }
+    if (i + 1 != argc) {
+        return usage();
+    }
+
+    return runQuery(argv[i], query, threads > 0 ? threads : 1);
+}